@@ -4,18 +4,73 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm> // all_of
+#include <atomic>
+#include <cmath>   // signbit, trunc
+#include <cstddef> // size_t
+#include <cstdint> // int64_t, uint64_t
+#include <memory>  // make_unique
+#include <mutex>   // lock_guard, mutex
+#include <span>
+#include <utility> // move
+#include <vector>
+
 #include "ruc/json/array.h"
 #include "ruc/json/value.h"
+#include "ruc/meta/assert.h"
 
 namespace ruc::json {
 
-void Array::emplace_back(Value element)
+static std::atomic<uint64_t> s_version { 0 };
+
+// Rarely taken, only the first const access to a packed array makes values
+static std::mutex s_elementsMutex;
+
+// Negative zero is kept as a double, integers would write it as 0
+static bool isIntegral(double number)
 {
-	m_elements.emplace_back(std::move(element));
+	return std::trunc(number) == number && number >= -9223372036854775808.0 && number < 9223372036854775808.0
+	       && !(number == 0 && std::signbit(number));
+}
+
+// -----------------------------------------
+
+Array::Array(std::vector<double> numbers)
+{
+	if (numbers.empty()) {
+		return;
+	}
+
+	m_packed = std::make_unique<Packed>();
+	if (!std::all_of(numbers.begin(), numbers.end(), isIntegral)) {
+		m_packed->packing = Packing::Double;
+		m_packed->doubles = std::move(numbers);
+		return;
+	}
+
+	m_packed->packing = Packing::Integer;
+	m_packed->integers.assign(numbers.begin(), numbers.end());
+}
+
+// -----------------------------------------
+
+void Array::reserve(size_t size)
+{
+	if (!isPacked()) {
+		m_elements.reserve(size);
+	}
+	else if (m_packed->packing == Packing::Integer) {
+		m_packed->integers.reserve(size);
+	}
+	else {
+		m_packed->doubles.reserve(size);
+	}
 }
 
 Value& Array::operator[](size_t index)
 {
+	lend();
+	unpack();
 	if (index + 1 > m_elements.size()) {
 		m_elements.resize(index + 1);
 	}
@@ -23,4 +78,135 @@ Value& Array::operator[](size_t index)
 	return m_elements[index];
 }
 
+std::span<const int64_t> Array::integers() const
+{
+	VERIFY(packing() == Packing::Integer, "array is not packed as integers");
+	return m_packed->integers;
+}
+
+std::span<const double> Array::doubles() const
+{
+	VERIFY(packing() == Packing::Double, "array is not packed as doubles");
+	return m_packed->doubles;
+}
+
+double Array::number(size_t index) const
+{
+	VERIFY(isPacked(), "array is not packed");
+	return m_packed->packing == Packing::Integer ? static_cast<double>(m_packed->integers[index]) : m_packed->doubles[index];
+}
+
+void Array::emplace_back(Value element)
+{
+	invalidate();
+	if (isPacked()) {
+		if (element.type() == Value::Type::Number) {
+			appendPacked(element.asDouble());
+			return;
+		}
+
+		unpack();
+	}
+
+	m_elements.emplace_back(std::move(element));
+}
+
+bool Array::pack()
+{
+	if (isPacked()) {
+		return true;
+	}
+
+	if (m_elements.empty()
+	    || !std::all_of(m_elements.begin(), m_elements.end(), [](const Value& element) { return element.type() == Value::Type::Number; })) {
+		return false;
+	}
+
+	invalidate();
+	if (!m_packed) {
+		m_packed = std::make_unique<Packed>();
+	}
+
+	auto& packed = *m_packed;
+	packed.integers.clear();
+	packed.doubles.clear();
+	if (std::all_of(m_elements.begin(), m_elements.end(), [](const Value& element) { return isIntegral(element.asDouble()); })) {
+		packed.packing = Packing::Integer;
+		packed.integers.reserve(m_elements.size());
+		for (const auto& element : m_elements) {
+			packed.integers.push_back(static_cast<int64_t>(element.asDouble()));
+		}
+	}
+	else {
+		packed.packing = Packing::Double;
+		packed.doubles.reserve(m_elements.size());
+		for (const auto& element : m_elements) {
+			packed.doubles.push_back(element.asDouble());
+		}
+	}
+
+	// Release the values, the packed buffer is a third of their size
+	std::vector<Value>().swap(m_elements);
+	return true;
+}
+
+void Array::unpack()
+{
+	if (!isPacked()) {
+		return;
+	}
+
+	if (!m_unpacked.load(std::memory_order_relaxed)) {
+		makeElements();
+	}
+	m_unpacked.store(false, std::memory_order_relaxed);
+	m_packed.reset();
+}
+
+void Array::appendPacked(double number)
+{
+	if (m_packed->packing == Packing::Integer && !isIntegral(number)) {
+		m_packed->doubles.reserve(m_packed->integers.capacity());
+		m_packed->doubles.assign(m_packed->integers.begin(), m_packed->integers.end());
+		m_packed->integers.clear();
+		m_packed->packing = Packing::Double;
+	}
+
+	if (m_packed->packing == Packing::Integer) {
+		m_packed->integers.push_back(static_cast<int64_t>(number));
+	}
+	else {
+		m_packed->doubles.push_back(number);
+	}
+}
+
+void Array::makeElements() const
+{
+	std::lock_guard<std::mutex> lock(s_elementsMutex);
+	if (m_unpacked.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	size_t size = m_packed->size();
+	m_elements.clear();
+	m_elements.reserve(size);
+	for (size_t i = 0; i < size; ++i) {
+		m_elements.emplace_back(number(i));
+	}
+
+	m_unpacked.store(true, std::memory_order_release);
+}
+
+uint64_t Array::version() const
+{
+	// Readers on other threads may assign it at the same time
+	uint64_t version = m_version.load(std::memory_order_relaxed);
+	if (version == 0) {
+		uint64_t next = s_version.fetch_add(1, std::memory_order_relaxed) + 1;
+		version = m_version.compare_exchange_strong(version, next, std::memory_order_relaxed) ? next : version;
+	}
+
+	return version;
+}
+
 } // namespace ruc::json
@@ -6,17 +6,44 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint> // int64_t, uint8_t, uint64_t
+#include <memory>  // make_unique, unique_ptr
+#include <span>
 #include <utility> // move
 #include <vector>
 
+#include "ruc/json/output.h"
 #include "ruc/json/parser.h"
 
 namespace ruc::json {
 
 class Value;
 
+// Arrays of only numbers can be stored packed, as a buffer of integers if every
+// number is integral or as a buffer of doubles otherwise. Large parsed arrays
+// of numbers and arrays made from vectors of numbers are packed automatically,
+// adding anything other than a number converts the array back to values.
+//
+// Element references need values. Mutable access converts a packed array,
+// const access through at() or elements() keeps it packed and makes the values
+// once, next to the packed buffer. Making them is synchronized, so packed
+// arrays can be read from multiple threads like any other, except while
+// Value::dumpCached keeps output.
 class Array {
+private:
+	friend class Index;
+	friend class Parser;
+	friend class Value;
+
 public:
+	enum class Packing : uint8_t {
+		None,    // Values
+		Integer, // int64_t, every number is integral
+		Double,  // double
+	};
+
 	Array() {}
 	virtual ~Array() {}
 
@@ -25,33 +52,137 @@ public:
 	{
 	}
 
+	// Packed, as integers if every number is integral
+	Array(std::vector<double> numbers);
+
 	Array(const Array& other)
-		: m_elements(other.m_elements)
+		: m_elements(other.isPacked() ? std::vector<Value>() : other.m_elements)
+		, m_packed(other.m_packed ? std::make_unique<Packed>(*other.m_packed) : nullptr)
+		, m_hash(other.cachedHash())
+	{
+	}
+
+	Array& operator=(const Array& other)
 	{
+		invalidate();
+		m_elements = other.isPacked() ? std::vector<Value>() : other.m_elements;
+		m_packed = other.m_packed ? std::make_unique<Packed>(*other.m_packed) : nullptr;
+		setCachedHash(other.cachedHash());
+		return *this;
 	}
 
 	// Capacity
 
-	bool empty() const { return m_elements.empty(); }
-	size_t size() const { return m_elements.size(); }
-	void reserve(size_t size) { m_elements.reserve(size); }
+	bool empty() const { return size() == 0; }
+	size_t size() const { return isPacked() ? m_packed->size() : m_elements.size(); }
+	void reserve(size_t size);
 
 	// Element access
 
 	Value& operator[](size_t index);
 
-	Value& at(size_t index) { return m_elements.at(index); }
-	const Value& at(size_t index) const { return m_elements.at(index); }
+	Value& at(size_t index)
+	{
+		lend();
+		unpack();
+		return m_elements.at(index);
+	}
+	const Value& at(size_t index) const { return elements().at(index); }
 
-	const std::vector<Value>& elements() const { return m_elements; }
+	const std::vector<Value>& elements() const
+	{
+		if (isPacked() && !m_unpacked.load(std::memory_order_acquire)) {
+			makeElements();
+		}
+		return m_elements;
+	}
+
+	// Packed access, without conversion
+
+	Packing packing() const { return m_packed ? m_packed->packing : Packing::None; }
+	std::span<const int64_t> integers() const;
+	std::span<const double> doubles() const;
+	double number(size_t index) const;
 
 	// Modifiers
 
-	void clear() { m_elements.clear(); }
+	void clear()
+	{
+		invalidate();
+		m_elements.clear();
+		m_packed.reset();
+		m_lent = false;
+	}
 	void emplace_back(Value element);
 
+	// Store the elements packed, false if not every element is a number
+	bool pack();
+	// Store the elements as values
+	void unpack();
+
+	// Hashing, 0 means no hash has been memoized
+
+	size_t cachedHash() const { return m_hash.load(std::memory_order_relaxed); }
+	void setCachedHash(size_t hash) const { m_hash.store(hash, std::memory_order_relaxed); }
+
+	// Output of a cached dump, nullptr if it has not been kept. Keeping output is
+	// not synchronized, see Value::dumpCached
+	const CachedOutput* cachedOutput() const { return m_cachedOutput.get(); }
+	// Whether a mutable reference to an element was handed out. Writes through
+	// it are not seen, so the output of this array is never kept
+	bool lent() const { return m_lent; }
+	void setCachedOutput(CachedOutput output) const { m_cachedOutput = std::make_unique<CachedOutput>(std::move(output)); }
+
+	// Identifies the current elements, it changes on every mutable access.
+	// Versions are unique across all arrays, so a replaced array never matches
+	uint64_t version() const;
+
 private:
-	std::vector<Value> m_elements;
+	struct Packed {
+		size_t size() const { return packing == Packing::Integer ? integers.size() : doubles.size(); }
+
+		Packing packing { Packing::None };
+		std::vector<int64_t> integers;
+		std::vector<double> doubles;
+	};
+
+	// Called on every mutable access, as the returned element may be modified
+	void invalidate()
+	{
+		m_hash.store(0, std::memory_order_relaxed);
+		m_version.store(0, std::memory_order_relaxed);
+		m_cachedOutput.reset();
+		if (m_unpacked.load(std::memory_order_relaxed)) {
+			m_elements.clear();
+			m_unpacked.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	// Called on mutable access that returns an element
+	void lend()
+	{
+		invalidate();
+		m_lent = true;
+	}
+
+	bool isPacked() const { return m_packed && m_packed->packing != Packing::None; }
+	// Appends to a packed array, switching from integers to doubles if needed
+	void appendPacked(double number);
+	// Values of a packed array for const access, see the class description
+	void makeElements() const;
+
+	// Buffers with packing None are kept by the parser, to pack into again
+	mutable std::vector<Value> m_elements;
+	std::unique_ptr<Packed> m_packed;
+	// Whether the elements hold the values of the packed buffer
+	mutable std::atomic<bool> m_unpacked { false };
+
+	// Readers on several threads may memoize the same hash
+	mutable std::atomic<size_t> m_hash { 0 };
+	mutable std::unique_ptr<CachedOutput> m_cachedOutput;
+	bool m_lent { false };
+	// 0 is unassigned, a version is only taken when it is asked for
+	mutable std::atomic<uint64_t> m_version { 0 };
 };
 
 } // namespace ruc::json
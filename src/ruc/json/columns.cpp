@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // min
+#include <cmath>     // trunc
+#include <cstddef>   // size_t
+#include <cstdint>   // int64_t, uint64_t
+#include <string>
+#include <string_view>
+
+#include "ruc/json/columns.h"
+#include "ruc/json/object.h"
+#include "ruc/json/value.h"
+#include "ruc/meta/assert.h"
+
+namespace ruc::json {
+
+static Column::Type columnType(const Value& value)
+{
+	switch (value.type()) {
+	case Value::Type::Bool:
+		return Column::Type::Bool;
+	case Value::Type::Number: {
+		double number = value.asDouble();
+		bool integral = std::trunc(number) == number && number >= -9223372036854775808.0 && number < 9223372036854775808.0;
+		return integral ? Column::Type::Integer : Column::Type::Double;
+	}
+	case Value::Type::String:
+		return Column::Type::String;
+	case Value::Type::Array:
+	case Value::Type::Object:
+		return Column::Type::Mixed;
+	case Value::Type::Null:
+	default:
+		return Column::Type::Null;
+	}
+}
+
+static Column::Type mergeTypes(Column::Type left, Column::Type right)
+{
+	if (left == right || right == Column::Type::Null) {
+		return left;
+	}
+	if (left == Column::Type::Null) {
+		return right;
+	}
+
+	if ((left == Column::Type::Integer && right == Column::Type::Double)
+	    || (left == Column::Type::Double && right == Column::Type::Integer)) {
+		return Column::Type::Double;
+	}
+
+	return Column::Type::Mixed;
+}
+
+// -----------------------------------------
+
+ColumnSet::ColumnSet(const Value& records)
+{
+	VERIFY(records.type() == Value::Type::Array, "records should be an array");
+
+	for (const auto& record : records.asArray().elements()) {
+		infer(record);
+	}
+
+	allocate();
+
+	size_t row = 0;
+	for (const auto& record : records.asArray().elements()) {
+		append(record, row++);
+	}
+
+	finish();
+}
+
+ColumnSet::~ColumnSet()
+{
+}
+
+// -----------------------------------------
+
+bool ColumnSet::parseNdjson(ColumnSet& columns, std::string_view input, size_t* line)
+{
+	// Both passes parse into the same record, which recycles its allocations
+	Value record;
+	auto forEachRecord = [&input, &line, &record](auto function) -> bool {
+		size_t number = 0;
+		for (size_t begin = 0; begin < input.size();) {
+			size_t end = std::min(input.find('\n', begin), input.size());
+			std::string_view text = input.substr(begin, end - begin);
+			begin = end + 1;
+			number++;
+
+			if (text.find_first_not_of(" \t\r") == std::string_view::npos) {
+				continue;
+			}
+
+			if (!Value::parseInto(record, text)) {
+				if (line) {
+					*line = number;
+				}
+				return false;
+			}
+			function(record);
+		}
+		return true;
+	};
+
+	columns = ColumnSet();
+	if (!forEachRecord([&columns](const Value& record) { columns.infer(record); })) {
+		columns = ColumnSet();
+		return false;
+	}
+
+	columns.allocate();
+
+	// The input did not change, so every line parses again
+	size_t row = 0;
+	forEachRecord([&columns, &row](const Value& record) { columns.append(record, row++); });
+
+	columns.finish();
+	return true;
+}
+
+// -----------------------------------------
+
+bool ColumnSet::exists(std::string_view name) const
+{
+	return m_names.find(name) != m_names.end();
+}
+
+const Column& ColumnSet::operator[](std::string_view name) const
+{
+	auto it = m_names.find(name);
+	VERIFY(it != m_names.end(), "column '{}' does not exist", name);
+	return m_columns[it->second];
+}
+
+// -----------------------------------------
+
+void ColumnSet::infer(const Value& record)
+{
+	m_rows++;
+
+	if (record.type() != Value::Type::Object) {
+		return;
+	}
+
+	for (const auto& [name, value] : record.asObject().members()) {
+		auto it = m_names.find(name);
+		if (it == m_names.end()) {
+			it = m_names.emplace(name, m_columns.size()).first;
+			m_columns.push_back({});
+			m_columns.back().name = name;
+		}
+
+		Column& column = m_columns[it->second];
+		column.type = mergeTypes(column.type, columnType(value));
+	}
+}
+
+void ColumnSet::allocate()
+{
+	for (auto& column : m_columns) {
+		column.validity.assign((m_rows + 63) / 64, 0);
+
+		switch (column.type) {
+		case Column::Type::Bool:
+			column.bools.assign(m_rows, 0);
+			break;
+		case Column::Type::Integer:
+			column.integers.assign(m_rows, 0);
+			break;
+		case Column::Type::Double:
+			column.doubles.assign(m_rows, 0);
+			break;
+		case Column::Type::String:
+			column.offsets.reserve(m_rows + 1);
+			column.offsets.push_back(0);
+			break;
+		case Column::Type::Mixed:
+			column.values.resize(m_rows);
+			break;
+		case Column::Type::Null:
+		default:
+			break;
+		}
+	}
+}
+
+void ColumnSet::append(const Value& record, size_t row)
+{
+	if (record.type() != Value::Type::Object) {
+		return;
+	}
+
+	// Members and column names are both sorted, so they can be walked side by side
+	auto it = m_names.begin();
+	for (const auto& [name, value] : record.asObject().members()) {
+		while (it->first != name) {
+			it++;
+		}
+
+		if (value.type() == Value::Type::Null) {
+			continue;
+		}
+
+		Column& column = m_columns[it->second];
+		column.validity[row / 64] |= 1ull << (row % 64);
+
+		switch (column.type) {
+		case Column::Type::Bool:
+			column.bools[row] = value.asBool();
+			break;
+		case Column::Type::Integer:
+			column.integers[row] = static_cast<int64_t>(value.asDouble());
+			break;
+		case Column::Type::Double:
+			column.doubles[row] = value.asDouble();
+			break;
+		case Column::Type::String:
+			// Rows in between without a value are empty
+			column.offsets.resize(row + 1, column.characters.size());
+			column.characters += value.asString();
+			column.offsets.push_back(column.characters.size());
+			break;
+		case Column::Type::Mixed:
+			column.values[row] = value;
+			break;
+		case Column::Type::Null:
+		default:
+			break;
+		}
+	}
+}
+
+void ColumnSet::finish()
+{
+	for (auto& column : m_columns) {
+		if (column.type == Column::Type::String) {
+			column.offsets.resize(m_rows + 1, column.characters.size());
+		}
+	}
+}
+
+} // namespace ruc::json
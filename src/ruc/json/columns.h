@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>    // size_t
+#include <cstdint>    // int64_t, uint8_t, uint64_t
+#include <functional> // less
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Values of a single member across all records, stored contiguously. Only the
+// vector that belongs to the type of the column is filled.
+struct Column {
+	enum class Type : uint8_t {
+		Null,    // Only null or missing values
+		Bool,    // bools
+		Integer, // integers, numbers that are all integral
+		Double,  // doubles
+		String,  // offsets and characters
+		Mixed,   // values, differing types or containers
+	};
+
+	bool isNull(size_t row) const { return !(validity[row / 64] >> (row % 64) & 1); }
+	std::string_view string(size_t row) const { return std::string_view(characters).substr(offsets[row], offsets[row + 1] - offsets[row]); }
+
+	std::string name;
+	Type type { Type::Null };
+
+	// One bit per row, set if the row has a value
+	std::vector<uint64_t> validity;
+
+	std::vector<uint8_t> bools;
+	std::vector<int64_t> integers;
+	std::vector<double> doubles;
+	std::vector<uint64_t> offsets; // Row i spans [offsets[i], offsets[i + 1]) of characters
+	std::string characters;
+	std::vector<Value> values;
+};
+
+// Converts an array of objects into one column per member name. The column
+// types are inferred in a first pass over the records, the values are copied
+// in a second pass. Records that are not objects become rows of nulls.
+class ColumnSet {
+public:
+	ColumnSet() = default;
+	ColumnSet(const Value& records);
+	virtual ~ColumnSet();
+
+	// Newline delimited records, every non-empty line is a row. On a line that
+	// does not parse, columns is left empty and line is set to its number,
+	// starting at 1.
+	static bool parseNdjson(ColumnSet& columns, std::string_view input, size_t* line = nullptr);
+
+	bool exists(std::string_view name) const;
+	const Column& operator[](std::string_view name) const;
+
+	size_t rows() const { return m_rows; }
+	const std::vector<Column>& columns() const { return m_columns; }
+
+private:
+	void infer(const Value& record);
+	void allocate();
+	void append(const Value& record, size_t row);
+	void finish();
+
+	size_t m_rows { 0 };
+	std::vector<Column> m_columns;
+	std::map<std::string, size_t, std::less<>> m_names;
+};
+
+} // namespace ruc::json
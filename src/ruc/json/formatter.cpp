@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstdint> // uint32_t
+#include <sstream> // stringstream
+#include <string_view>
+
+#include "ruc/format/builder.h"
+#include "ruc/format/parser.h"
+#include "ruc/json/formatter.h"
+#include "ruc/json/value.h"
+#include "ruc/json/writer.h"
+
+void ruc::format::Formatter<ruc::json::Value>::parse(Parser& parser)
+{
+	parser.parseSpecifier(specifier, Parser::ParameterType::UserDefined);
+}
+
+void ruc::format::Formatter<ruc::json::Value>::format(Builder& builder, const ruc::json::Value& value) const
+{
+	uint32_t indent = specifier.width > 0 ? specifier.width : 4;
+	if (specifier.type == PresentationType::Character) {
+		indent = 0;
+	}
+
+	std::stringstream& stream = builder.builder();
+	ruc::json::Writer writer([&stream](std::string_view chunk) { stream.write(chunk.data(), chunk.size()); }, indent, specifier.fill);
+	writer.value(value);
+	writer.flush();
+}
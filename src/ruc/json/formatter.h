@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "ruc/format/builder.h"
+#include "ruc/format/formatter.h"
+#include "ruc/format/parser.h"
+#include "ruc/json/value.h"
+
+// Serializes into the builder in chunks. The width is the indent, 4 if it is
+// omitted, the fill is the indent character and type 'c' is compact, for
+// example {:2}, {:\t<1} or {:c}
+template<>
+struct ruc::format::Formatter<ruc::json::Value> {
+	Specifier specifier;
+
+	void parse(Parser& parser);
+	void format(Builder& builder, const ruc::json::Value& value) const;
+};
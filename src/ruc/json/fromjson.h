@@ -7,10 +7,14 @@
 #pragma once
 
 #include <algorithm> // transform
+#include <charconv>  // from_chars
 #include <cstddef>   // nullptr_t, size_t
 #include <cstdint>   // int32_t, int64_t, uint32_t
 #include <map>
 #include <string>
+#include <string_view>
+#include <system_error> // errc
+#include <type_traits>  // is_same_v
 #include <unordered_map>
 #include <utility> // forward
 #include <vector>
@@ -50,6 +54,16 @@ template<typename Json, Integral T>
 void fromJson(const Json& json, T& number)
 {
 	VERIFY(json.type() == Json::Type::Number);
+
+	// Raw integers are read directly, beyond the precision of a double
+	std::string_view raw = json.rawNumber();
+	if (!raw.empty()) {
+		auto [end, error] = std::from_chars(raw.data(), raw.data() + raw.size(), number);
+		if (end == raw.data() + raw.size() && error == std::errc()) {
+			return;
+		}
+	}
+
 	number = static_cast<T>(json.asDouble());
 }
 
@@ -71,6 +85,20 @@ template<typename Json, typename T>
 void fromJson(const Json& json, std::vector<T>& array)
 {
 	VERIFY(json.type() == Json::Type::Array);
+
+	// Packed numbers are copied as a whole, without checking every element
+	if constexpr ((Integral<T> && !std::is_same_v<T, bool>) || FloatingPoint<T>) {
+		const Array& source = json.asArray();
+		if (source.packing() == Array::Packing::Integer) {
+			array.assign(source.integers().begin(), source.integers().end());
+			return;
+		}
+		if (source.packing() == Array::Packing::Double) {
+			array.assign(source.doubles().begin(), source.doubles().end());
+			return;
+		}
+	}
+
 	array.resize(json.size());
 	std::transform(
 		json.asArray().elements().begin(),
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // all_of, equal, min
+#include <atomic>
+#include <cstddef>   // size_t
+#include <string>    // stoull
+#include <utility>   // move
+#include <vector>
+
+#include "ruc/json/array.h"
+#include "ruc/json/index.h"
+#include "ruc/json/object.h"
+#include "ruc/json/value.h"
+#include "ruc/meta/assert.h"
+
+namespace ruc::json {
+
+Index::Index(const Value& records, const std::vector<std::string>& paths, Type type)
+	: m_records(records)
+	, m_type(type)
+{
+	VERIFY(!paths.empty(), "index needs at least one path");
+
+	for (const auto& path : paths) {
+		VERIFY(path.empty() || path[0] == '/', "invalid path '{}'", path);
+
+		auto& segments = m_paths.emplace_back();
+		for (size_t begin = 1; begin <= path.size() && !path.empty();) {
+			size_t end = std::min(path.find('/', begin), path.size());
+
+			// Decode the escape sequences ~1 and ~0
+			std::string name;
+			for (size_t i = begin; i < end; ++i) {
+				if (path[i] == '~' && i + 1 < end && (path[i + 1] == '0' || path[i + 1] == '1')) {
+					name += path[++i] == '0' ? '~' : '/';
+					continue;
+				}
+				name += path[i];
+			}
+
+			// Numeric segments also select array elements
+			Segment segment { Key(name) };
+			if (!name.empty() && name.size() < 20 && std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+				segment.index = std::stoull(name);
+			}
+			segments.push_back(std::move(segment));
+
+			begin = end + 1;
+		}
+	}
+
+	rebuild();
+}
+
+Index::~Index()
+{
+}
+
+// -----------------------------------------
+
+bool Index::stale() const
+{
+	return m_records.type() != Value::Type::Array || m_records.asArray().m_version.load(std::memory_order_relaxed) != m_version;
+}
+
+void Index::rebuild()
+{
+	VERIFY(m_records.type() == Value::Type::Array, "records should be an array");
+
+	const auto& elements = m_records.asArray().elements();
+
+	// Keep the load factor at or below one half
+	size_t capacity = 8;
+	while (capacity < elements.size() * 2) {
+		capacity *= 2;
+	}
+	m_slots.assign(capacity, {});
+	m_size = 0;
+
+	std::vector<const Value*> values;
+	std::vector<const Value*> existing;
+	for (size_t element = 0; element < elements.size(); ++element) {
+		if (!resolveAll(elements[element], values, true)) {
+			continue;
+		}
+
+		size_t hash = 0;
+		for (const Value* value : values) {
+			hash = hash * 31 + ruc::json::hash(*value);
+		}
+
+		size_t slot = hash & (capacity - 1);
+		for (; m_slots[slot].element != s_empty; slot = (slot + 1) & (capacity - 1)) {
+			if (m_type == Type::Multiple || m_slots[slot].hash != hash) {
+				continue;
+			}
+
+			resolveAll(elements[m_slots[slot].element], existing, true);
+			if (std::equal(values.begin(), values.end(), existing.begin(), [](const Value* left, const Value* right) { return *left == *right; })) {
+				break;
+			}
+		}
+
+		if (m_slots[slot].element == s_empty) {
+			m_slots[slot] = { hash, element };
+			m_size++;
+		}
+	}
+
+	m_version = m_records.asArray().version();
+}
+
+template<typename Function>
+void Index::probe(const Value& key, Function function) const
+{
+	// Elements may have moved, nothing is found until the index is rebuilt
+	if (stale()) {
+		return;
+	}
+
+	size_t hash = hashKey(key);
+	size_t mask = m_slots.size() - 1;
+	const auto& elements = m_records.asArray().elements();
+	for (size_t slot = hash & mask; m_slots[slot].element != s_empty; slot = (slot + 1) & mask) {
+		if (m_slots[slot].hash != hash) {
+			continue;
+		}
+
+		const Value& element = elements[m_slots[slot].element];
+		if (matches(element, key) && !function(element)) {
+			return;
+		}
+	}
+}
+
+const Value* Index::find(const Value& key) const
+{
+	const Value* result = nullptr;
+	probe(key, [&result](const Value& element) {
+		result = &element;
+		return false;
+	});
+
+	return result;
+}
+
+std::vector<const Value*> Index::findAll(const Value& key) const
+{
+	// Equal keys are probed in the order they were inserted, which is the
+	// order of the elements
+	std::vector<const Value*> result;
+	probe(key, [&result](const Value& element) {
+		result.push_back(&element);
+		return true;
+	});
+
+	return result;
+}
+
+// -----------------------------------------
+
+const Value* Index::resolve(const Value& element, const std::vector<Segment>& path, bool cache) const
+{
+	// Keys remember their slot, but can not be shared between threads, so only
+	// rebuilding uses them
+	const Value* value = &element;
+	for (const auto& segment : path) {
+		if (value->type() == Value::Type::Object) {
+			value = cache ? value->asObject().find(segment.name) : value->asObject().find(segment.name.name());
+		}
+		else if (value->type() == Value::Type::Array && segment.index < value->asArray().size()) {
+			value = &value->asArray().elements()[segment.index];
+		}
+		else {
+			value = nullptr;
+		}
+
+		if (value == nullptr) {
+			return nullptr;
+		}
+	}
+
+	return value;
+}
+
+bool Index::resolveAll(const Value& element, std::vector<const Value*>& values, bool cache) const
+{
+	values.clear();
+	for (const auto& path : m_paths) {
+		const Value* value = resolve(element, path, cache);
+		if (value == nullptr) {
+			return false;
+		}
+		values.push_back(value);
+	}
+
+	return true;
+}
+
+size_t Index::hashKey(const Value& key) const
+{
+	if (m_paths.size() == 1) {
+		return hash(key);
+	}
+
+	VERIFY(key.type() == Value::Type::Array && key.size() == m_paths.size(),
+	       "key should be an array of {} values", m_paths.size());
+
+	size_t result = 0;
+	for (const auto& value : key.asArray().elements()) {
+		result = result * 31 + hash(value);
+	}
+
+	return result;
+}
+
+bool Index::matches(const Value& element, const Value& key) const
+{
+	if (m_paths.size() == 1) {
+		const Value* value = resolve(element, m_paths[0], false);
+		return value != nullptr && *value == key;
+	}
+
+	for (size_t i = 0; i < m_paths.size(); ++i) {
+		const Value* value = resolve(element, m_paths[i], false);
+		if (value == nullptr || !(*value == key.asArray().elements()[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace ruc::json
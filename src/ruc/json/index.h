@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint64_t
+#include <limits>  // numeric_limits
+#include <string>
+#include <vector>
+
+#include "ruc/json/key.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Hash index over the elements of an array, by the values at one or more
+// paths inside every element. Paths are JSON Pointers relative to the element,
+// elements that are missing any of the paths are not indexed.
+//
+// The index remembers the version of the array it was built from and becomes
+// stale on any mutable access to the array, also reads through the non-const
+// accessors. A stale index finds nothing until it is rebuilt, check stale()
+// before relying on a miss. Note that modifying an element through a retained
+// reference is not seen.
+class Index {
+public:
+	enum class Type : uint8_t {
+		Unique,   // One element per key, the first one wins
+		Multiple, // Every element with the key
+	};
+
+	Index(const Value& records, const std::vector<std::string>& paths, Type type = Type::Unique);
+	virtual ~Index();
+
+	bool stale() const;
+	void rebuild();
+
+	// Keys of indexes with multiple paths are arrays, with a value per path.
+	// Returns nullptr if there is no element with this key or the index is stale
+	const Value* find(const Value& key) const;
+	std::vector<const Value*> findAll(const Value& key) const;
+
+	// Number of indexed elements
+	size_t size() const { return m_size; }
+
+private:
+	static constexpr size_t s_empty = std::numeric_limits<size_t>::max();
+
+	struct Segment {
+		Key name;
+		size_t index { s_empty }; // Set if the segment is an array index
+	};
+
+	struct Slot {
+		size_t hash { 0 };
+		size_t element { s_empty };
+	};
+
+	// Returns nullptr if the value does not have the path
+	const Value* resolve(const Value& element, const std::vector<Segment>& path, bool cache) const;
+	bool resolveAll(const Value& element, std::vector<const Value*>& values, bool cache) const;
+	size_t hashKey(const Value& key) const;
+	bool matches(const Value& element, const Value& key) const;
+
+	template<typename Function>
+	void probe(const Value& key, Function function) const;
+
+	const Value& m_records;
+	std::vector<std::vector<Segment>> m_paths;
+	Type m_type { Type::Unique };
+
+	uint64_t m_version { 0 };
+	size_t m_size { 0 };
+	std::vector<Slot> m_slots; // Open addressing, the size is a power of two
+};
+
+} // namespace ruc::json
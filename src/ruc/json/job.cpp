@@ -5,23 +5,23 @@
  */
 
 #include <algorithm> // count
+#include <cstdint>   // uint64_t
 #include <sstream>   // istringstream
 #include <string>    // getline
+#include <utility>   // move
 
 #include "ruc/json/job.h"
 #include "ruc/json/lexer.h"
 #include "ruc/json/parser.h"
+#include "ruc/json/stats.h"
 #include "ruc/json/value.h"
+#include "ruc/timer.h"
 
 namespace ruc::json {
 
 Job::Job(std::string_view input)
 	: m_input(input)
 {
-	// FIXME: Make this work for all newline types: \n, \r, \r\n
-	m_lineNumbersWidth = std::count(m_input.begin(), m_input.end(), '\n');
-	m_lineNumbersWidth += m_input.back() == '\n' ? 0 : 1;
-	m_lineNumbersWidth = std::to_string(m_lineNumbersWidth).length();
 }
 
 Job::~Job()
@@ -30,23 +30,64 @@ Job::~Job()
 
 // ------------------------------------------
 
+void Job::reset(std::string_view input)
+{
+	m_success = true;
+	m_input = input;
+
+	// Keep the symbol buffers, in reverse so every token gets its own buffer back
+	for (auto it = m_tokens.rbegin(); it != m_tokens.rend(); ++it) {
+		if (it->type == Token::Type::String || it->type == Token::Type::Number || it->type == Token::Type::Literal) {
+			m_symbols.push_back(std::move(it->symbol));
+		}
+	}
+	m_tokens.clear();
+}
+
 Value Job::fire()
 {
+	Value value;
+	fireInto(value);
+	return value;
+}
+
+bool Job::fireInto(Value& target)
+{
+	Timer timer;
 	Lexer lexer(this);
 	lexer.analyze();
+	uint64_t lexNanoseconds = m_collectStats ? timer.elapsedNanoseconds() : 0;
+
+	if (m_success) {
+		m_parser.parseInto(target);
+	}
 
 	if (!m_success) {
-		return nullptr;
+		target = nullptr;
 	}
 
-	Parser parser(this);
-	Value value = parser.parse();
+	if (m_collectStats) {
+		uint64_t totalNanoseconds = timer.elapsedNanoseconds();
+		m_stats = measure(target);
+		m_stats.bytes = m_input.size();
+		m_stats.tokens = m_tokens.size();
+		m_stats.lexNanoseconds = lexNanoseconds;
+		m_stats.parseNanoseconds = totalNanoseconds - lexNanoseconds;
+	}
 
-	if (!m_success) {
-		return nullptr;
+	return m_success;
+}
+
+std::string Job::takeSymbol()
+{
+	if (m_symbols.empty()) {
+		return {};
 	}
 
-	return value;
+	std::string symbol = std::move(m_symbols.back());
+	m_symbols.pop_back();
+	symbol.clear();
+	return symbol;
 }
 
 void Job::printErrorLine(Token token, const char* message)
@@ -83,9 +124,14 @@ void Job::printErrorLine(Token token, const char* message)
 	}
 	token.column += line.length() - oldLineLength;
 
+	// FIXME: Make this work for all newline types: \n, \r, \r\n
+	size_t lineNumbersWidth = std::count(m_input.begin(), m_input.end(), '\n');
+	lineNumbersWidth += !m_input.empty() && m_input.back() == '\n' ? 0 : 1;
+	lineNumbersWidth = std::to_string(lineNumbersWidth).length();
+
 	// JSON line
 	std::string lineFormat = " %"
-	                         + std::to_string(m_lineNumbersWidth)
+	                         + std::to_string(lineNumbersWidth)
 	                         + "zu | "
 	                           "%s"
 	                           "\033[31;1m" // Bold red
@@ -106,7 +152,7 @@ void Job::printErrorLine(Token token, const char* message)
 							  "\n";
 	fprintf(stderr,
 	        arrowFormat.c_str(),
-	        std::string(m_lineNumbersWidth, ' ').c_str(),
+	        std::string(lineNumbersWidth, ' ').c_str(),
 	        std::string(token.column, ' ').c_str(),
 	        std::string(line.length() - token.column, '~').c_str());
 }
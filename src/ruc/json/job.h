@@ -7,35 +7,66 @@
 #pragma once
 
 #include <cstddef> // size_t
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "ruc/json/lexer.h"
+#include "ruc/json/parser.h"
+#include "ruc/json/stats.h"
+#include "ruc/json/value.h"
 
 namespace ruc::json {
 
-class Value;
-
+// Lexes and parses a single input. A job can be reset and fired again, which
+// reuses its token buffer and parser scratch buffers.
 class Job {
 public:
-	Job(std::string_view input);
+	Job(std::string_view input = {});
 	virtual ~Job();
 
+	// Start over with new input, keeping the buffers of the previous run
+	void reset(std::string_view input);
+
 	Value fire();
+	// Parse into target, recycling its allocations. On failure target is null
+	bool fireInto(Value& target);
 
 	void printErrorLine(Token token, const char* message);
 
+	// Symbol buffer of a token from a previous run, for the lexer
+	std::string takeSymbol();
+
+	// Maximum nesting depth of arrays and objects, 0 is unlimited
+	void setMaxDepth(size_t maxDepth) { m_maxDepth = maxDepth; }
+	// Time the lexer and parser and measure the result, see stats()
+	void setCollectStats(bool collectStats) { m_collectStats = collectStats; }
+	// Keep the text of numbers, see Value::parseRawNumbers
+	void setRawNumbers(bool rawNumbers) { m_rawNumbers = rawNumbers; }
+
 	bool success() const { return m_success; }
+	size_t maxDepth() const { return m_maxDepth; }
+	bool rawNumbers() const { return m_rawNumbers; }
+	const ParseStats& stats() const { return m_stats; }
 	std::string_view input() const { return m_input; }
 	std::vector<Token>* tokens() { return &m_tokens; }
+	// Positions of the opening tokens the lexer has not seen closed yet
+	std::vector<size_t>* openTokens() { return &m_openTokens; }
 
 private:
 	bool m_success { true };
 
 	std::string_view m_input;
-	size_t m_lineNumbersWidth { 0 };
+	size_t m_maxDepth { 0 };
+	bool m_collectStats { false };
+	bool m_rawNumbers { false };
+	ParseStats m_stats;
 
 	std::vector<Token> m_tokens;
+	std::vector<size_t> m_openTokens;
+	std::vector<std::string> m_symbols;
+
+	Parser m_parser { this };
 };
 
 } // namespace ruc::json
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "ruc/json/formatter.h"
+#include "ruc/json/literal.h"
 #include "ruc/json/value.h"
 
 namespace ruc {
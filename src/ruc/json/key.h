@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>    // size_t
+#include <cstdint>    // uint64_t
+#include <functional> // hash
+#include <string>
+#include <string_view>
+
+namespace ruc::json {
+
+// Member name with a precomputed hash, for names that are looked up often.
+// Every thread remembers where a key was last found, in a small table indexed
+// by the hash, so repeated lookups in the same object skip the search and all
+// name comparisons. The remembered position is dropped when members are
+// removed from that object. For shaped objects the slot of the name is
+// remembered instead, which holds for every object that shares the shape.
+//
+// Keys are not modified by lookups, a key can be shared between threads.
+class Key {
+private:
+	friend class Object;
+
+public:
+	explicit Key(std::string_view name);
+
+	const std::string& name() const { return m_name; }
+	size_t hash() const { return m_hash; }
+
+	bool operator==(const Key& other) const { return m_hash == other.m_hash && m_name == other.m_name; }
+
+private:
+	std::string m_name;
+	size_t m_hash { 0 };
+	// Identifies the key in the lookup tables, copies share it
+	uint64_t m_id { 0 };
+};
+
+} // namespace ruc::json
+
+template<>
+struct std::hash<ruc::json::Key> {
+	size_t operator()(const ruc::json::Key& key) const
+	{
+		return key.hash();
+	}
+};
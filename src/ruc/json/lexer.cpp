@@ -6,6 +6,8 @@
 
 #include <cstddef>
 #include <string>
+#include <utility> // move
+#include <vector>
 
 #include "ruc/json/job.h"
 #include "ruc/json/lexer.h"
@@ -16,6 +18,7 @@ Lexer::Lexer(Job* job)
 	: GenericLexer(job->input())
 	, m_job(job)
 	, m_tokens(job->tokens())
+	, m_open(job->openTokens())
 {
 }
 
@@ -27,29 +30,45 @@ Lexer::~Lexer()
 
 void Lexer::analyze()
 {
+	m_count = true;
+	m_open->clear();
+	while (next()) {
+	}
+}
+
+bool Lexer::next()
+{
+	size_t count = m_tokens->size();
 	while (m_index < m_input.length()) {
 		switch (peek()) {
 		case '{':
+			open();
 			m_tokens->push_back({ Token::Type::BraceOpen, m_line, m_column, "{" });
 			break;
 		case '}':
 			m_tokens->push_back({ Token::Type::BraceClose, m_line, m_column, "}" });
+			close();
 			break;
 		case '[':
+			open();
 			m_tokens->push_back({ Token::Type::BracketOpen, m_line, m_column, "[" });
 			break;
 		case ']':
 			m_tokens->push_back({ Token::Type::BracketClose, m_line, m_column, "]" });
+			close();
 			break;
 		case ':':
 			m_tokens->push_back({ Token::Type::Colon, m_line, m_column, ":" });
 			break;
 		case ',':
+			if (m_count && !m_open->empty()) {
+				(*m_tokens)[m_open->back()].count++;
+			}
 			m_tokens->push_back({ Token::Type::Comma, m_line, m_column, "," });
 			break;
 		case '"':
 			if (!consumeString()) {
-				return;
+				return false;
 			}
 			break;
 		case '-':
@@ -64,7 +83,7 @@ void Lexer::analyze()
 		case '8':
 		case '9':
 			if (!consumeNumber()) {
-				return;
+				return false;
 			}
 			break;
 		case 'a':
@@ -94,7 +113,7 @@ void Lexer::analyze()
 		case 'y':
 		case 'z':
 			if (!consumeLiteral()) {
-				return;
+				return false;
 			}
 			break;
 		case ' ':
@@ -116,12 +135,42 @@ void Lexer::analyze()
 			m_tokens->push_back({ Token::Type::None, m_line, m_column, std::string(1, peek()) });
 			m_job->printErrorLine(m_tokens->back(),
 			                      (std::string() + "unexpected character '" + peek() + "'").c_str());
-			return;
+			return false;
 			break;
 		}
 
 		ignore();
 		m_column++;
+
+		if (m_tokens->size() != count) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// -----------------------------------------
+
+void Lexer::open()
+{
+	if (m_count) {
+		m_open->push_back(m_tokens->size());
+	}
+}
+
+void Lexer::close()
+{
+	if (!m_count || m_open->empty()) {
+		return;
+	}
+
+	// Commas were counted so far. The count is a capacity hint for the parser,
+	// mismatched closing tokens are reported by the parser
+	size_t open = m_open->back();
+	m_open->pop_back();
+	if (open + 2 != m_tokens->size()) {
+		(*m_tokens)[open].count++;
 	}
 }
 
@@ -130,7 +179,7 @@ void Lexer::analyze()
 bool Lexer::consumeString()
 {
 	size_t column = m_column;
-	std::string symbol = "";
+	std::string symbol = m_job->takeSymbol();
 
 	bool escape = false;
 	char character = consume();
@@ -160,7 +209,7 @@ bool Lexer::consumeString()
 		}
 	}
 
-	m_tokens->push_back({ Token::Type::String, m_line, column, symbol });
+	m_tokens->push_back({ Token::Type::String, m_line, column, std::move(symbol) });
 
 	if (character != '"') {
 		m_job->printErrorLine(m_job->tokens()->back(), "strings should be wrapped in double quotes");
@@ -196,8 +245,9 @@ bool Lexer::consumeNumberOrLiteral(Token::Type type)
 		ignore();
 	}
 
-	m_tokens->push_back({ type, m_line, column,
-	                      std::string(m_input.substr(index, m_index - index)) });
+	std::string symbol = m_job->takeSymbol();
+	symbol.assign(m_input.substr(index, m_index - index));
+	m_tokens->push_back({ type, m_line, column, std::move(symbol) });
 
 	retreat();
 
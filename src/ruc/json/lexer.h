@@ -38,6 +38,8 @@ struct Token {
 	size_t line { 0 };
 	size_t column { 0 };
 	std::string symbol;
+	// Number of elements or members, on opening tokens if counted by analyze()
+	size_t count { 0 };
 };
 
 // Lexical analyzer
@@ -46,9 +48,15 @@ public:
 	Lexer(Job* job);
 	virtual ~Lexer();
 
+	// Lex all tokens, counting the elements of every array and object
 	void analyze();
+	// Lex up to and including the next token, false at the end or on error
+	bool next();
 
 private:
+	void open();
+	void close();
+
 	bool consumeString();
 	bool consumeNumberOrLiteral(Token::Type type);
 	bool consumeNumber();
@@ -60,6 +68,10 @@ private:
 	size_t m_line { 0 };
 
 	std::vector<Token>* m_tokens { nullptr };
+
+	// Containers that are still open, only tracked while counting
+	bool m_count { false };
+	std::vector<size_t>* m_open { nullptr };
 };
 
 } // namespace ruc::json
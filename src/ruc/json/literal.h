@@ -0,0 +1,513 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm> // min
+#include <array>
+#include <bit>     // bit_cast, endian
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t, uint64_t
+#include <limits>  // numeric_limits
+#include <utility> // pair
+
+#include "ruc/json/tape.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Document from a _jsondoc literal, parsed at compile time into the format of a
+// Tape. It is constant-initialized and read through a TapeValue view, or copied
+// into a mutable Value.
+template<size_t Words, size_t Strings>
+struct StaticDocument {
+	TapeValue root() const { return TapeValue(words.data(), strings.data(), 0); }
+	Value toValue() const { return root().toValue(); }
+
+	std::array<uint64_t, Words> words {};
+	std::array<char, Strings> strings {};
+};
+
+namespace detail {
+
+// String literal as a template argument
+template<size_t N>
+struct Literal {
+	consteval Literal(const char (&input)[N])
+	{
+		for (size_t i = 0; i < N; ++i) {
+			data[i] = input[i];
+		}
+	}
+
+	char data[N] {};
+};
+
+// Not constexpr, so reaching it while parsing a literal is a build error that
+// points at the call with the message
+void invalidJsonLiteral(const char* message);
+
+// Parses a literal into tape words and strings, or only counts them when there
+// is nowhere to write to. Input is accepted like the runtime parser does and
+// strings keep their escape sequences the same way. Numbers with at most 15
+// significant digits and an exponent of at most 22 convert exactly, others can
+// differ from the runtime parser in the last bit
+class LiteralParser {
+public:
+	constexpr LiteralParser(const char* input, size_t size, uint64_t* words = nullptr, char* strings = nullptr)
+		: m_input(input)
+		, m_size(size)
+		, m_words(words)
+		, m_strings(strings)
+	{
+	}
+
+	constexpr void parse()
+	{
+		parseValue();
+		skipWhitespace();
+		if (m_index != m_size) {
+			invalidJsonLiteral("multiple root elements");
+		}
+	}
+
+	constexpr size_t words() const { return m_wordCount; }
+	constexpr size_t strings() const { return m_stringCount; }
+
+private:
+	constexpr char peek() const { return m_index < m_size ? m_input[m_index] : '\0'; }
+
+	constexpr bool isDelimiter(char character) const
+	{
+		return character == '{' || character == '}' || character == '[' || character == ']'
+		       || character == ':' || character == ',' || character == '"'
+		       || character == ' ' || character == '\t' || character == '\r' || character == '\n'
+		       || character == '\0';
+	}
+
+	constexpr void skipWhitespace()
+	{
+		while (peek() == ' ' || peek() == '\t' || peek() == '\r' || peek() == '\n') {
+			m_index++;
+		}
+	}
+
+	constexpr void appendWord(uint64_t word)
+	{
+		if (m_words != nullptr) {
+			m_words[m_wordCount] = word;
+		}
+		m_wordCount++;
+	}
+
+	constexpr void appendCharacter(char character)
+	{
+		if (m_strings != nullptr) {
+			m_strings[m_stringCount] = character;
+		}
+		m_stringCount++;
+	}
+
+	// Lengths are stored in native byte order, like Tape does with memcpy
+	constexpr void writeLength(size_t offset, uint32_t length)
+	{
+		for (size_t i = 0; i < sizeof(length); ++i) {
+			size_t shift = std::endian::native == std::endian::little ? i : sizeof(length) - 1 - i;
+			m_strings[offset + i] = static_cast<char>((length >> (shift * 8)) & 0xff);
+		}
+	}
+
+	constexpr uint32_t readLength(size_t offset) const
+	{
+		uint32_t length = 0;
+		for (size_t i = 0; i < sizeof(length); ++i) {
+			size_t shift = std::endian::native == std::endian::little ? i : sizeof(length) - 1 - i;
+			length |= static_cast<uint32_t>(static_cast<unsigned char>(m_strings[offset + i])) << (shift * 8);
+		}
+		return length;
+	}
+
+	constexpr void parseValue()
+	{
+		skipWhitespace();
+
+		char character = peek();
+		switch (character) {
+		case '[':
+		case '{':
+			parseContainer(character == '[');
+			break;
+		case '"':
+			parseString();
+			break;
+		case 't':
+			parseLiteral("true", TapeTag::True);
+			break;
+		case 'f':
+			parseLiteral("false", TapeTag::False);
+			break;
+		case 'n':
+			parseLiteral("null", TapeTag::Null);
+			break;
+		default:
+			if (character == '-' || (character >= '0' && character <= '9')) {
+				parseNumber();
+				break;
+			}
+			invalidJsonLiteral(character == '\0' ? "expecting value, not 'EOF'" : "expecting value");
+		}
+	}
+
+	constexpr void parseContainer(bool isArray)
+	{
+		char close = isArray ? ']' : '}';
+
+		m_index++;
+		size_t index = m_wordCount;
+		appendWord(encodeTapeWord(isArray ? TapeTag::Array : TapeTag::Object));
+
+		size_t count = 0;
+		skipWhitespace();
+		if (peek() == close) {
+			m_index++;
+		}
+		else {
+			for (;;) {
+				if (!isArray) {
+					skipWhitespace();
+					if (peek() != '"') {
+						invalidJsonLiteral("expecting string");
+					}
+					parseString();
+					skipWhitespace();
+					if (peek() != ':') {
+						invalidJsonLiteral("expecting colon");
+					}
+					m_index++;
+				}
+
+				parseValue();
+				count++;
+
+				skipWhitespace();
+				if (peek() == ',') {
+					m_index++;
+					continue;
+				}
+				if (peek() == close) {
+					m_index++;
+					break;
+				}
+				invalidJsonLiteral(isArray ? "expecting comma or ']'" : "expecting comma or '}'");
+			}
+		}
+
+		if (m_words != nullptr) {
+			m_words[index] |= std::min(static_cast<uint64_t>(count), s_tapeCountMask) << 32 | m_wordCount;
+			if (!isArray) {
+				checkNames(index);
+			}
+		}
+	}
+
+	constexpr void parseString()
+	{
+		m_index++;
+		size_t offset = m_stringCount;
+		for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+			appendCharacter('\0');
+		}
+
+		// Same as Parser::consumeString, escaped characters are stored as they
+		// would be printed
+		bool escape = false;
+		for (;;) {
+			if (m_index >= m_size) {
+				invalidJsonLiteral("expecting closing '\"' at end");
+			}
+
+			char character = m_input[m_index++];
+			if (!escape) {
+				if (character == '\\') {
+					escape = true;
+					continue;
+				}
+				if (character == '"') {
+					break;
+				}
+				if (character >= 0 && character <= 31) {
+					invalidJsonLiteral("invalid string, unescaped character found");
+				}
+				appendCharacter(character);
+				continue;
+			}
+
+			escape = false;
+			switch (character) {
+			case '"':
+			case '\\':
+				appendCharacter('\\');
+				appendCharacter(character);
+				break;
+			case '\b':
+				appendCharacter('\\');
+				appendCharacter('b');
+				break;
+			case '\f':
+				appendCharacter('\\');
+				appendCharacter('f');
+				break;
+			case '\n':
+				appendCharacter('\\');
+				appendCharacter('n');
+				break;
+			case '\r':
+				appendCharacter('\\');
+				appendCharacter('r');
+				break;
+			case '\t':
+				appendCharacter('\\');
+				appendCharacter('t');
+				break;
+			default:
+				if (character >= 0 && character <= 31) {
+					const char* hex = "0123456789ABCDEF";
+					appendCharacter('\\');
+					appendCharacter('u');
+					appendCharacter('0');
+					appendCharacter('0');
+					appendCharacter(hex[character >> 4]);
+					appendCharacter(hex[character & 0xf]);
+					break;
+				}
+				appendCharacter(character);
+				break;
+			}
+		}
+
+		size_t length = m_stringCount - offset - sizeof(uint32_t);
+		if (length > std::numeric_limits<uint32_t>::max()) {
+			invalidJsonLiteral("string too large");
+		}
+		if (m_strings != nullptr) {
+			writeLength(offset, static_cast<uint32_t>(length));
+		}
+		appendCharacter('\0');
+
+		appendWord(encodeTapeWord(TapeTag::String, offset));
+	}
+
+	constexpr void parseLiteral(const char* text, TapeTag tag)
+	{
+		for (; *text != '\0'; ++text, ++m_index) {
+			if (peek() != *text) {
+				invalidJsonLiteral("invalid literal");
+			}
+		}
+		if (!isDelimiter(peek())) {
+			invalidJsonLiteral("invalid literal");
+		}
+
+		appendWord(encodeTapeWord(tag));
+	}
+
+	constexpr void parseNumber()
+	{
+		// number = [ minus ] int [ frac ] [ exp ]
+
+		bool negative = peek() == '-';
+		if (negative) {
+			m_index++;
+		}
+
+		auto isDigit = [this]() { return peek() >= '0' && peek() <= '9'; };
+		if (!isDigit()) {
+			invalidJsonLiteral("expected number after minus");
+		}
+
+		// Significant digits that fit, the others only move the exponent
+		uint64_t mantissa = 0;
+		int64_t exponent = 0;
+		auto addDigit = [&mantissa, &exponent](char digit, bool fraction) {
+			if (mantissa < 100000000000000000ull) {
+				mantissa = mantissa * 10 + static_cast<uint64_t>(digit - '0');
+				exponent -= fraction;
+			}
+			else {
+				exponent += !fraction;
+			}
+		};
+
+		if (peek() == '0') {
+			m_index++;
+			if (isDigit()) {
+				invalidJsonLiteral("invalid leading zero");
+			}
+		}
+		while (isDigit()) {
+			addDigit(m_input[m_index++], false);
+		}
+
+		if (peek() == '.') {
+			m_index++;
+			if (!isDigit()) {
+				invalidJsonLiteral("invalid number");
+			}
+			while (isDigit()) {
+				addDigit(m_input[m_index++], true);
+			}
+		}
+
+		if (peek() == 'e' || peek() == 'E') {
+			m_index++;
+			bool negativeExponent = peek() == '-';
+			if (peek() == '-' || peek() == '+') {
+				m_index++;
+			}
+			if (!isDigit()) {
+				invalidJsonLiteral("invalid exponent sign, expected number");
+			}
+
+			int64_t value = 0;
+			while (isDigit()) {
+				value = std::min<int64_t>(value * 10 + (m_input[m_index++] - '0'), 100000);
+			}
+			exponent += negativeExponent ? -value : value;
+		}
+
+		if (!isDelimiter(peek())) {
+			invalidJsonLiteral("invalid number");
+		}
+
+		double number = toDouble(mantissa, exponent);
+		if (number > std::numeric_limits<double>::max()) {
+			invalidJsonLiteral("number out of range");
+		}
+
+		appendWord(encodeTapeWord(TapeTag::Number));
+		appendWord(std::bit_cast<uint64_t>(negative ? -number : number));
+	}
+
+	static constexpr double toDouble(uint64_t mantissa, int64_t exponent)
+	{
+		if (mantissa == 0) {
+			return 0.0;
+		}
+
+		// Both operands are exact, so the one rounding step is correct
+		if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+			double scale = 1.0;
+			for (int64_t i = 0; i < (exponent < 0 ? -exponent : exponent); ++i) {
+				scale *= 10.0;
+			}
+			return exponent < 0 ? static_cast<double>(mantissa) / scale : static_cast<double>(mantissa) * scale;
+		}
+
+		long double result = static_cast<long double>(mantissa);
+		for (; exponent > 0; --exponent) {
+			result *= 10.0L;
+		}
+		for (; exponent < 0; ++exponent) {
+			result /= 10.0L;
+		}
+		return static_cast<double>(result);
+	}
+
+	constexpr size_t skip(size_t index) const
+	{
+		switch (static_cast<TapeTag>(m_words[index] >> 56)) {
+		case TapeTag::Number:
+			return index + 2;
+		case TapeTag::Array:
+		case TapeTag::Object:
+			return m_words[index] & s_tapeEndMask;
+		default:
+			return index + 1;
+		}
+	}
+
+	// Names should be unique, like for Tape::parse
+	constexpr void checkNames(size_t index) const
+	{
+		size_t end = m_words[index] & s_tapeEndMask;
+		for (size_t left = index + 1; left < end; left = skip(left + 1)) {
+			for (size_t right = skip(left + 1); right < end; right = skip(right + 1)) {
+				size_t leftOffset = m_words[left] & s_tapeEndMask;
+				size_t rightOffset = m_words[right] & s_tapeEndMask;
+				uint32_t length = readLength(leftOffset);
+				if (length != readLength(rightOffset)) {
+					continue;
+				}
+
+				bool equal = true;
+				for (size_t i = sizeof(uint32_t); i < sizeof(uint32_t) + length && equal; ++i) {
+					equal = m_strings[leftOffset + i] == m_strings[rightOffset + i];
+				}
+				if (equal) {
+					invalidJsonLiteral("duplicate name, names should be unique");
+				}
+			}
+		}
+	}
+
+	const char* m_input { nullptr };
+	size_t m_size { 0 };
+	size_t m_index { 0 };
+
+	uint64_t* m_words { nullptr };
+	char* m_strings { nullptr };
+	size_t m_wordCount { 0 };
+	size_t m_stringCount { 0 };
+};
+
+template<Literal L>
+consteval auto parseLiteral()
+{
+	constexpr size_t size = sizeof(L.data) - 1;
+	constexpr std::pair<size_t, size_t> counts = []() {
+		LiteralParser parser(L.data, size);
+		parser.parse();
+		return std::pair(parser.words(), parser.strings());
+	}();
+
+	StaticDocument<counts.first, counts.second> document;
+	LiteralParser parser(L.data, size, document.words.data(), document.strings.data());
+	parser.parse();
+	return document;
+}
+
+// Constant-initialized, one instance per distinct literal
+template<Literal L>
+inline constexpr auto literalDocument = parseLiteral<L>();
+
+} // namespace detail
+
+} // namespace ruc::json
+
+/**
+ * User-defined string literal, parsed at compile time. Malformed JSON does not
+ * build. Every use converts the parsed document into a new Value
+ *
+ * Example usage: auto json = "[ 3.14, true, null ]"_json;
+ *                json[0] = 2.72;
+ */
+template<ruc::json::detail::Literal L>
+ruc::json::Value operator"" _json()
+{
+	return ruc::json::detail::literalDocument<L>.toValue();
+}
+
+/**
+ * User-defined string literal, parsed at compile time into a constant
+ * document. It is read in place without allocating, or converted to a Value
+ *
+ * Example usage: double pi = "[ 3.14 ]"_jsondoc.root()[0].asDouble();
+ */
+template<ruc::json::detail::Literal L>
+constexpr const auto& operator"" _jsondoc()
+{
+	return ruc::json::detail::literalDocument<L>;
+}
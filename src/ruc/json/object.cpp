@@ -4,23 +4,210 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <array>
+#include <atomic>
+#include <cstddef>    // size_t
+#include <cstdint>    // uint64_t
+#include <functional> // hash
+#include <memory>     // shared_ptr
+#include <stdexcept>  // out_of_range
+#include <string>
+#include <string_view>
+#include <utility> // as_const, move
+
+#include "ruc/json/key.h"
 #include "ruc/json/object.h"
+#include "ruc/json/shape.h"
 #include "ruc/json/value.h"
 
 namespace ruc::json {
 
+// Unique for every set of members that keys have been looked up in
+static std::atomic<uint64_t> s_generation { 0 };
+// Unique for every key, 0 is none
+static std::atomic<uint64_t> s_keyId { 0 };
+
+// Where a key was last found by this thread
+struct KeyPosition {
+	uint64_t id { 0 };
+
+	// Generation of the object the member was last found in, 0 is none
+	uint64_t generation { 0 };
+	Value* value { nullptr };
+
+	// Shape the slot was last resolved in, kept alive so it can not be reused
+	std::shared_ptr<const Shape> shape;
+	size_t slot { 0 };
+};
+
+static constexpr size_t s_keyPositions = 64;
+
+static KeyPosition& keyPosition(const Key& key, uint64_t id)
+{
+	thread_local std::array<KeyPosition, s_keyPositions> positions;
+
+	KeyPosition& position = positions[key.hash() % s_keyPositions];
+	if (position.id != id) {
+		position = KeyPosition {};
+		position.id = id;
+	}
+	return position;
+}
+
+// -----------------------------------------
+
+Key::Key(std::string_view name)
+	: m_name(name)
+	, m_hash(std::hash<std::string_view> {}(name))
+	, m_id(s_keyId.fetch_add(1, std::memory_order_relaxed) + 1)
+{
+}
+
+// -----------------------------------------
+
 void Object::emplace(const std::string& name, Value value)
 {
+	invalidate();
+	if (isShaped() && m_slots->shape->find(name) != Shape::npos) {
+		return;
+	}
+
+	unshape();
 	m_members.emplace(name, std::move(value));
 }
 
-Value& Object::operator[](const std::string& name)
+Value& Object::operator[](std::string_view name)
 {
-	if (m_members.find(name) == m_members.end()) {
-		emplace(name, {});
+	lend();
+	if (isShaped()) {
+		size_t slot = m_slots->shape->find(name);
+		if (slot != Shape::npos) {
+			return m_slots->values[slot];
+		}
+		unshape();
+	}
+
+	auto it = m_members.lower_bound(name);
+	if (it == m_members.end() || it->first != name) {
+		it = m_members.emplace_hint(it, std::string(name), Value {});
+	}
+
+	return it->second;
+}
+
+Value& Object::operator[](const Key& key)
+{
+	lend();
+	if (Value* value = lookup(key)) {
+		return *value;
+	}
+
+	Value& value = (*this)[std::string_view(key.name())];
+	lookup(key);
+	return value;
+}
+
+Value& Object::at(std::string_view name)
+{
+	lend();
+	return const_cast<Value&>(std::as_const(*this).at(name));
+}
+
+Value& Object::at(const Key& key)
+{
+	lend();
+	return const_cast<Value&>(std::as_const(*this).at(key));
+}
+
+const Value& Object::at(std::string_view name) const
+{
+	const Value* value = find(name);
+	if (value == nullptr) {
+		throw std::out_of_range("Object::at");
+	}
+
+	return *value;
+}
+
+const Value& Object::at(const Key& key) const
+{
+	const Value* value = lookup(key);
+	if (value == nullptr) {
+		throw std::out_of_range("Object::at");
+	}
+
+	return *value;
+}
+
+const Value* Object::find(std::string_view name) const
+{
+	if (isShaped()) {
+		size_t slot = m_slots->shape->find(name);
+		return slot != Shape::npos ? &m_slots->values[slot] : nullptr;
+	}
+
+	auto it = m_members.find(name);
+	return it != m_members.end() ? &it->second : nullptr;
+}
+
+// -----------------------------------------
+
+Value* Object::lookup(const Key& key) const
+{
+	KeyPosition& position = keyPosition(key, key.m_id);
+
+	// The slot is resolved once per shape
+	if (isShaped()) {
+		const auto& shape = m_slots->shape;
+		if (position.shape != shape) {
+			size_t slot = shape->find(key.name());
+			if (slot == Shape::npos) {
+				return nullptr;
+			}
+			position.shape = shape;
+			position.slot = slot;
+		}
+
+		// Values are only handed out mutably through the non-const accessors
+		return &m_slots->values[position.slot];
+	}
+
+	uint64_t generation = m_generation.load(std::memory_order_relaxed);
+	if (generation != 0 && position.generation == generation) {
+		return position.value;
+	}
+
+	auto it = m_members.find(std::string_view(key.name()));
+	if (it == m_members.end()) {
+		return nullptr;
+	}
+
+	// Readers on other threads may assign it at the same time
+	if (generation == 0) {
+		uint64_t next = s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+		generation = m_generation.compare_exchange_strong(generation, next, std::memory_order_relaxed) ? next : generation;
+	}
+
+	// Members are only handed out mutably through the non-const accessors
+	position.generation = generation;
+	position.value = const_cast<Value*>(&it->second);
+	return position.value;
+}
+
+void Object::unshape()
+{
+	if (!isShaped()) {
+		return;
+	}
+
+	const auto& names = m_slots->shape->names();
+	for (size_t i = 0; i < names.size(); ++i) {
+		m_members.emplace_hint(m_members.end(), names[i], std::move(m_slots->values[i]));
 	}
 
-	return m_members.at(name);
+	m_slots->shape.reset();
+	m_slots->values.clear();
+	invalidateKeys();
 }
 
 } // namespace ruc::json
@@ -6,47 +6,197 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>    // ptrdiff_t, size_t
+#include <cstdint>    // uint64_t
+#include <functional> // less
+#include <iterator>   // forward_iterator_tag
 #include <map>
+#include <memory> // make_unique, shared_ptr, unique_ptr
 #include <string>
-#include <utility> // move
+#include <string_view>
+#include <utility> // move, pair
+#include <vector>
 
+#include "ruc/json/key.h"
+#include "ruc/json/output.h"
 #include "ruc/json/parser.h"
+#include "ruc/json/shape.h"
 
 namespace ruc::json {
 
+class Object;
 class Value;
 
+// Read-only view of the members of an object in name order, for objects that
+// store their members by name as well as for shaped objects
+class Members {
+public:
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::pair<const std::string&, const Value&>;
+		using reference = value_type;
+		using pointer = void;
+
+		Iterator() = default;
+		Iterator(std::map<std::string, Value, std::less<>>::const_iterator member)
+			: m_member(member)
+		{
+		}
+		Iterator(const std::string* name, const Value* value)
+			: m_name(name)
+			, m_value(value)
+		{
+		}
+
+		value_type operator*() const { return { name(), value() }; }
+		Iterator& operator++();
+		Iterator operator++(int);
+		bool operator==(const Iterator& other) const;
+		bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+		const std::string& name() const;
+		const Value& value() const;
+
+	private:
+		// Objects with a shape walk their names and values side by side
+		std::map<std::string, Value, std::less<>>::const_iterator m_member {};
+		const std::string* m_name { nullptr };
+		const Value* m_value { nullptr };
+	};
+
+	Members(const Object& object)
+		: m_object(object)
+	{
+	}
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	bool empty() const { return size() == 0; }
+	size_t size() const;
+
+private:
+	const Object& m_object;
+};
+
 class Object {
+private:
+	friend class Members;
+	friend class Parser;
+	friend class Value;
+
 public:
 	Object() {}
 	virtual ~Object() {}
 
 	Object(const Object& other)
 		: m_members(other.m_members)
+		, m_slots(other.isShaped() ? std::make_unique<Slots>(*other.m_slots) : nullptr)
+		, m_hash(other.cachedHash())
 	{
 	}
 
+	Object& operator=(const Object& other)
+	{
+		invalidate();
+		invalidateKeys();
+		m_members = other.m_members;
+		m_slots = other.isShaped() ? std::make_unique<Slots>(*other.m_slots) : nullptr;
+		setCachedHash(other.cachedHash());
+		return *this;
+	}
+
 	// Capacity
 
-	bool empty() const { return m_members.empty(); }
-	size_t size() const { return m_members.size(); }
+	bool empty() const { return size() == 0; }
+	size_t size() const { return isShaped() ? m_slots->shape->size() : m_members.size(); }
 
 	// Member access
 
-	Value& operator[](const std::string& name);
+	Value& operator[](std::string_view name);
+	Value& operator[](const Key& key);
+
+	Value& at(std::string_view name);
+	Value& at(const Key& key);
+	const Value& at(std::string_view name) const;
+	const Value& at(const Key& key) const;
+
+	// Returns nullptr if there is no member with this name
+	const Value* find(std::string_view name) const;
+	const Value* find(const Key& key) const { return lookup(key); }
 
-	Value& at(const std::string& name) { return m_members.at(name); }
-	const Value& at(const std::string& name) const { return m_members.at(name); }
+	Members members() const { return Members(*this); }
 
-	const std::map<std::string, Value>& members() const { return m_members; }
+	// Names shared with other objects, nullptr if members are stored by name
+	const Shape* shape() const { return isShaped() ? m_slots->shape.get() : nullptr; }
 
 	// Modifiers
 
-	void clear() { m_members.clear(); }
+	void clear()
+	{
+		invalidate();
+		invalidateKeys();
+		m_members.clear();
+		m_slots.reset();
+		m_lent = false;
+	}
 	void emplace(const std::string& name, Value value);
 
+	// Hashing, 0 means no hash has been memoized
+
+	size_t cachedHash() const { return m_hash.load(std::memory_order_relaxed); }
+	void setCachedHash(size_t hash) const { m_hash.store(hash, std::memory_order_relaxed); }
+
+	// Output of a cached dump, nullptr if it has not been kept. Keeping output is
+	// not synchronized, see Value::dumpCached
+	const CachedOutput* cachedOutput() const { return m_cachedOutput.get(); }
+	// Whether a mutable reference to a member was handed out. Writes through
+	// it are not seen, so the output of this object is never kept
+	bool lent() const { return m_lent; }
+	void setCachedOutput(CachedOutput output) const { m_cachedOutput = std::make_unique<CachedOutput>(std::move(output)); }
+
 private:
-	std::map<std::string, Value> m_members;
+	// Called on every mutable access, as the returned member may be modified
+	void invalidate()
+	{
+		m_hash.store(0, std::memory_order_relaxed);
+		m_cachedOutput.reset();
+	}
+	// Called on mutable access that returns a member
+	void lend()
+	{
+		invalidate();
+		m_lent = true;
+	}
+	// Called when members are removed, as keys may remember their position
+	void invalidateKeys() { m_generation = 0; }
+
+	bool isShaped() const { return m_slots && m_slots->shape; }
+	Value* lookup(const Key& key) const;
+	// Store the members by name again, before adding names. The value storage
+	// is kept, as a parse into this object usually shapes it again
+	void unshape();
+
+	// Values at the slots of the shape, kept out of line so that objects which
+	// store their members by name only pay for a pointer
+	struct Slots {
+		std::shared_ptr<const Shape> shape;
+		std::vector<Value> values;
+	};
+
+	// Members by name, if there is no shape
+	std::map<std::string, Value, std::less<>> m_members;
+	std::unique_ptr<Slots> m_slots;
+
+	// Readers on several threads may memoize the same hash
+	mutable std::atomic<size_t> m_hash { 0 };
+	mutable std::unique_ptr<CachedOutput> m_cachedOutput;
+	bool m_lent { false };
+	// Identifies the current set of members for key lookups, 0 is unassigned
+	mutable std::atomic<uint64_t> m_generation { 0 };
 };
 
 } // namespace ruc::json
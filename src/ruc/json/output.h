@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint> // uint32_t
+#include <string>
+
+namespace ruc::json {
+
+// Serialized text of a container, kept by a cached dump until the container is
+// modified. Indented output depends on the nesting level, so that is kept too
+struct CachedOutput {
+	bool matches(uint32_t indent, char indentCharacter, uint32_t indentLevel) const
+	{
+		return this->indent == indent
+		       && (indent == 0 || (this->indentCharacter == indentCharacter && this->indentLevel == indentLevel));
+	}
+
+	uint32_t indent { 0 };
+	char indentCharacter { ' ' };
+	uint32_t indentLevel { 0 };
+	std::string text;
+};
+
+} // namespace ruc::json
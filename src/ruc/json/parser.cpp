@@ -4,18 +4,22 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <algorithm> // count
+#include <algorithm> // count, equal
 #include <cstddef>   // size_t
 #include <cstdint>   // uint8_t
-#include <cstdio>    // printf
 #include <map>
-#include <string> // stod
+#include <memory>    // make_shared, make_unique, shared_ptr
+#include <string>    // stod
+#include <tuple>     // tie
+#include <utility>   // move
 
 #include "ruc/json/array.h"
 #include "ruc/json/job.h"
 #include "ruc/json/lexer.h"
 #include "ruc/json/object.h"
 #include "ruc/json/parser.h"
+#include "ruc/json/serializer.h"
+#include "ruc/json/shape.h"
 #include "ruc/json/value.h"
 #include "ruc/meta/assert.h"
 
@@ -36,48 +40,37 @@ Parser::~Parser()
 Value Parser::parse()
 {
 	Value result;
+	parseInto(result);
+	return result;
+}
+
+void Parser::parseInto(Value& target)
+{
+	m_index = 0;
 
 	if (m_tokens->size() == 0) {
 		m_job->printErrorLine({}, "expecting token, not 'EOF'");
-		return result;
-	}
-
-	Token token = peek();
-	switch (token.type) {
-	case Token::Type::Literal:
-		result = consumeLiteral();
-		break;
-	case Token::Type::Number:
-		result = consumeNumber();
-		break;
-	case Token::Type::String:
-		result = consumeString();
-		break;
-	case Token::Type::BracketOpen:
-		result = consumeArray();
-		break;
-	case Token::Type::BraceOpen:
-		result = consumeObject();
-		break;
-	case Token::Type::BracketClose:
-		m_job->printErrorLine(token, "expecting value, not ']'");
-		m_index++;
-		break;
-	case Token::Type::BraceClose:
-		m_job->printErrorLine(token, "expecting string, not '}'");
-		m_index++;
-		break;
-	default:
-		m_job->printErrorLine(token, "multiple root elements");
-		m_index++;
-		break;
+		return;
 	}
 
-	if (!isEOF()) {
+	consumeValue(target);
+
+	if (m_job->success() && !isEOF()) {
 		m_job->printErrorLine(peek(), "multiple root elements");
 	}
 
-	return result;
+	// Release what a failed parse left behind, and the buffers of deep input
+	for (auto& members : m_spareMembers) {
+		recycleMembers(members);
+	}
+	if (m_spareMembers.size() > s_spareMaximum) {
+		m_spareMembers.resize(s_spareMaximum);
+		m_spareMembers.shrink_to_fit();
+	}
+	if (m_spareShapes.size() > s_spareMaximum) {
+		m_spareShapes.resize(s_spareMaximum);
+		m_spareShapes.shrink_to_fit();
+	}
 }
 
 // -----------------------------------------
@@ -87,28 +80,438 @@ bool Parser::isEOF()
 	return m_index >= m_tokens->size();
 }
 
-Token Parser::peek()
+const Token& Parser::peek()
 {
 	VERIFY(!isEOF());
 	return (*m_tokens)[m_index];
 }
 
-Token Parser::consume()
+const Token& Parser::consume()
 {
 	VERIFY(!isEOF());
 	return (*m_tokens)[m_index++];
 }
 
-void Parser::ignoreUntil(Token::Type type)
+Value Parser::consumeValue()
+{
+	Value result;
+	consumeValue(result);
+	return result;
+}
+
+void Parser::consumeValue(Value& target)
+{
+	// Containers are parsed with an explicit stack instead of recursion, so
+	// deeply nested input can not overflow the call stack
+	m_stack.clear();
+
+	Value* slot = &target;
+	for (;;) {
+		// Parse the value at the current slot, reusing what it already holds
+
+		if (isEOF()) {
+			m_job->printErrorLine(m_tokens->back(), "expecting value, not 'EOF'");
+			return;
+		}
+
+		const Token& token = peek();
+		switch (token.type) {
+		case Token::Type::Literal:
+			*slot = consumeLiteral();
+			break;
+		case Token::Type::Number:
+			*slot = consumeNumber();
+			break;
+		case Token::Type::String:
+			if (slot->m_type == Value::Type::String) {
+				slot->m_value.string->clear();
+				consumeString(*slot->m_value.string);
+			}
+			else {
+				*slot = consumeString();
+			}
+			break;
+		case Token::Type::BracketOpen:
+		case Token::Type::BraceOpen: {
+			size_t maxDepth = m_job->maxDepth();
+			if (maxDepth > 0 && m_stack.size() >= maxDepth) {
+				m_job->printErrorLine(token, "exceeded maximum nesting depth");
+				return;
+			}
+
+			m_index++;
+			bool isArray = token.type == Token::Type::BracketOpen;
+			Value::Type type = isArray ? Value::Type::Array : Value::Type::Object;
+			if (slot->m_type != type) {
+				*slot = type;
+			}
+
+			m_stack.push_back({ slot, 0 });
+			openContainer(*slot);
+
+			if (isArray) {
+				// Large arrays of only numbers are packed, without storing values first.
+				// Packing stores binary numbers, so raw numbers are never packed
+				if (token.count >= s_packMinimum && !m_job->rawNumbers() && consumePacked(*slot->m_value.array, token.count)) {
+					m_stack.pop_back();
+					break;
+				}
+
+				// The lexer counted the elements, so the storage is allocated once
+				slot->m_value.array->m_elements.reserve(token.count);
+			}
+
+			// Empty container
+			if (!isEOF() && peek().type == (isArray ? Token::Type::BracketClose : Token::Type::BraceClose)) {
+				m_index++;
+				closeContainer(m_stack.back());
+				m_stack.pop_back();
+				break;
+			}
+
+			slot = isArray ? consumeElement(m_stack.back()) : consumeMember(m_stack.back());
+			if (slot == nullptr) {
+				return;
+			}
+			continue;
+		}
+		default:
+			m_job->printErrorLine(token, ("expecting value, not '" + token.symbol + "'").c_str());
+			return;
+		}
+
+		if (!m_job->success()) {
+			return;
+		}
+
+		// The value is complete, close finished containers until the next slot is found
+
+		for (slot = nullptr; slot == nullptr;) {
+			if (m_stack.empty()) {
+				return;
+			}
+
+			Frame& frame = m_stack.back();
+			bool isArray = frame.container->m_type == Value::Type::Array;
+			Token::Type close = isArray ? Token::Type::BracketClose : Token::Type::BraceClose;
+
+			// EOF
+			if (isEOF()) {
+				m_job->printErrorLine(m_tokens->back(), isArray ? "expecting closing ']' at end" : "expecting closing '}' at end");
+				return;
+			}
+
+			// Find , or ] or }
+			const Token& separator = consume();
+			if (separator.type == close) {
+				closeContainer(frame);
+				m_stack.pop_back();
+				continue;
+			}
+			if (separator.type != Token::Type::Comma) {
+				m_job->printErrorLine(separator, (std::string("expecting comma or '") + (isArray ? ']' : '}')
+				                                  + "', not '" + separator.symbol + "'")
+				                                     .c_str());
+				return;
+			}
+
+			// Trailing comma
+			if (!isEOF() && peek().type == close) {
+				m_job->printErrorLine(separator, isArray ? "invalid comma, expecting ']'" : "invalid comma, expecting '}'");
+				return;
+			}
+
+			slot = isArray ? consumeElement(frame) : consumeMember(frame);
+			if (slot == nullptr) {
+				return;
+			}
+		}
+	}
+}
+
+bool Parser::consumePacked(Array& array, size_t count)
+{
+	// The tokens should alternate between a number and a comma, up to the
+	// closing bracket
+	size_t end = m_index + count * 2 - 1;
+	if (end >= m_tokens->size() || (*m_tokens)[end].type != Token::Type::BracketClose) {
+		return false;
+	}
+	bool integers = true;
+	for (size_t i = m_index; i < end; i += 2) {
+		const Token& token = (*m_tokens)[i];
+		if (token.type != Token::Type::Number || (i + 1 < end && (*m_tokens)[i + 1].type != Token::Type::Comma)) {
+			return false;
+		}
+		// Negative zero is written as -0 only by doubles
+		integers = integers && token.symbol.find_first_of(".eE") == std::string::npos && token.symbol != "-0";
+	}
+
+	// Values left by an earlier parse are not reused
+	std::vector<Value>().swap(array.m_elements);
+	if (!array.m_packed) {
+		array.m_packed = std::make_unique<Array::Packed>();
+	}
+	auto& packed = *array.m_packed;
+	packed.packing = integers ? Array::Packing::Integer : Array::Packing::Double;
+	if (integers) {
+		packed.integers.reserve(count);
+	}
+	else {
+		packed.doubles.reserve(count);
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		Value number = consumeNumber();
+		if (!m_job->success()) {
+			return true;
+		}
+		array.appendPacked(number.asDouble());
+
+		// Comma or closing bracket
+		m_index++;
+	}
+
+	return true;
+}
+
+Value* Parser::consumeElement(Frame& frame)
 {
-	while (!isEOF() && peek().type != type) {
-		++m_index;
+	// Reuse the elements that are already in the array
+	auto& elements = frame.container->m_value.array->m_elements;
+	Value* element = frame.count < elements.size() ? &elements[frame.count] : &elements.emplace_back();
+	frame.count++;
+	return element;
+}
+
+Value* Parser::consumeMember(Frame& frame)
+{
+	// Find member name
+	if (isEOF()) {
+		m_job->printErrorLine(m_tokens->back(), "expecting string, not 'EOF'");
+		return nullptr;
 	}
+
+	const Token& token = peek();
+	if (token.type != Token::Type::String) {
+		m_job->printErrorLine(token, ("expecting string or '}', not '" + token.symbol + "'").c_str());
+		return nullptr;
+	}
+
+	m_name.clear();
+	if (!consumeString(m_name)) {
+		return nullptr;
+	}
+
+	// Reuse the member with the same name from the previous parse, or a spare
+	// node of any other member
+	auto& members = frame.container->m_value.object->m_members;
+	auto node = m_spareMembers[m_stack.size() - 1].extract(m_name);
+	if (node.empty() && !m_spareNodes.empty()) {
+		node = std::move(m_spareNodes.back());
+		m_spareNodes.pop_back();
+		node.key() = m_name;
+	}
+
+	std::map<std::string, Value, std::less<>>::iterator it;
+	bool inserted = false;
+	if (node.empty()) {
+		std::tie(it, inserted) = members.try_emplace(m_name);
+	}
+	else {
+		auto result = members.insert(std::move(node));
+		it = result.position;
+		inserted = result.inserted;
+		if (!inserted) {
+			recycleNode(std::move(result.node));
+		}
+	}
+
+	if (!inserted) {
+		m_job->printErrorLine(token, ("duplicate name '" + token.symbol + "', names should be unique").c_str());
+		return nullptr;
+	}
+
+	// Find :
+	if (isEOF()) {
+		m_job->printErrorLine(token, "expecting colon, not 'EOF'");
+		return nullptr;
+	}
+	const Token& colon = consume();
+	if (colon.type != Token::Type::Colon) {
+		m_job->printErrorLine(colon, ("expecting colon, not '" + colon.symbol + "'").c_str());
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
+void Parser::openContainer(Value& container)
+{
+	if (container.m_type == Value::Type::Array) {
+		Array& array = *container.m_value.array;
+		array.invalidate();
+
+		// Keep the packed buffers, to pack into again
+		if (array.isPacked()) {
+			array.m_packed->packing = Array::Packing::None;
+			array.m_packed->integers.clear();
+			array.m_packed->doubles.clear();
+		}
+		return;
+	}
+
+	Object& object = *container.m_value.object;
+	object.invalidate();
+	object.invalidateKeys();
+
+	// Move the existing members aside, they are picked up again by name
+	size_t depth = m_stack.size();
+	if (m_spareMembers.size() < depth) {
+		m_spareMembers.resize(depth);
+	}
+	auto& spare = m_spareMembers[depth - 1];
+	if (!spare.empty()) {
+		// Left behind by a parse that failed
+		recycleMembers(spare);
+	}
+
+	if (!object.isShaped()) {
+		spare.swap(object.m_members);
+		return;
+	}
+
+	// Shaped objects hand their values out by name as well, in spare nodes
+	auto& slots = *object.m_slots;
+	const auto& names = slots.shape->names();
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (m_spareNodes.empty()) {
+			spare.emplace_hint(spare.end(), names[i], std::move(slots.values[i]));
+			continue;
+		}
+
+		auto node = std::move(m_spareNodes.back());
+		m_spareNodes.pop_back();
+		node.key() = names[i];
+		node.mapped() = std::move(slots.values[i]);
+		spare.insert(spare.end(), std::move(node));
+	}
+	slots.values.clear();
+	if (m_spareShapes.size() < depth) {
+		m_spareShapes.resize(depth);
+	}
+	m_spareShapes[depth - 1] = std::move(slots.shape);
+}
+
+void Parser::closeContainer(Frame& frame)
+{
+	if (frame.container->m_type == Value::Type::Array) {
+		Array& array = *frame.container->m_value.array;
+		array.m_elements.erase(array.m_elements.begin() + frame.count, array.m_elements.end());
+
+		// Packed arrays never get here, release the buffers of an earlier parse
+		array.m_packed.reset();
+		return;
+	}
+
+	// Members that did not occur again are kept for other objects
+	recycleMembers(m_spareMembers[m_stack.size() - 1]);
+
+	shapeObject(frame);
+}
+
+void Parser::recycleMembers(std::map<std::string, Value, std::less<>>& members)
+{
+	while (!members.empty()) {
+		recycleNode(members.extract(members.begin()));
+	}
+}
+
+void Parser::recycleNode(std::map<std::string, Value, std::less<>>::node_type&& node)
+{
+	if (m_spareNodes.size() >= s_spareMaximum) {
+		return; // Freed with the node
+	}
+
+	node.mapped() = nullptr;
+	m_spareNodes.push_back(std::move(node));
+}
+
+void Parser::shapeObject(Frame& frame)
+{
+	// Only the elements of an array are shaped, when they have the same names
+	// as the element before them
+	if (m_stack.size() < 2 || m_stack[m_stack.size() - 2].container->m_type != Value::Type::Array) {
+		return;
+	}
+
+	Object& object = *frame.container->m_value.object;
+	Frame& parent = m_stack[m_stack.size() - 2];
+	if (object.m_members.empty() || parent.count < 2) {
+		return;
+	}
+
+	Value& sibling = parent.container->m_value.array->m_elements[parent.count - 2];
+	if (sibling.m_type != Value::Type::Object) {
+		return;
+	}
+
+	auto sameNames = [&object](const auto& names, auto name) {
+		return names.size() == object.m_members.size()
+		       && std::equal(names.begin(), names.end(), object.m_members.begin(),
+		                     [&name](const auto& left, const auto& right) { return name(left) == right.first; });
+	};
+	auto shapeName = [](const std::string& name) -> const std::string& { return name; };
+	auto memberName = [](const auto& member) -> const std::string& { return member.first; };
+
+	Object& previous = *sibling.m_value.object;
+	std::shared_ptr<const Shape> shape = previous.isShaped() ? previous.m_slots->shape : nullptr;
+	if (shape) {
+		if (!sameNames(shape->names(), shapeName)) {
+			return;
+		}
+	}
+	else {
+		if (!sameNames(previous.m_members, memberName)) {
+			return;
+		}
+
+		// Reuse the shape these objects had before this parse
+		shape = m_stack.size() <= m_spareShapes.size() ? m_spareShapes[m_stack.size() - 1] : nullptr;
+		if (!shape || !sameNames(shape->names(), shapeName)) {
+			std::vector<std::string> names;
+			names.reserve(object.m_members.size());
+			for (const auto& member : object.m_members) {
+				names.push_back(member.first);
+			}
+			shape = std::make_shared<const Shape>(std::move(names));
+		}
+		shapeMembers(previous, shape);
+	}
+
+	shapeMembers(object, std::move(shape));
+}
+
+void Parser::shapeMembers(Object& object, std::shared_ptr<const Shape> shape)
+{
+	if (!object.m_slots) {
+		object.m_slots = std::make_unique<Object::Slots>();
+	}
+
+	auto& slots = *object.m_slots;
+	slots.values.reserve(object.m_members.size());
+	while (!object.m_members.empty()) {
+		auto node = object.m_members.extract(object.m_members.begin());
+		slots.values.push_back(std::move(node.mapped()));
+		recycleNode(std::move(node));
+	}
+
+	slots.shape = std::move(shape);
 }
 
 Value Parser::consumeLiteral()
 {
-	Token token = consume();
+	const Token& token = consume();
 
 	if (token.symbol == "null") {
 		return nullptr;
@@ -126,9 +529,9 @@ Value Parser::consumeLiteral()
 
 Value Parser::consumeNumber()
 {
-	Token token = consume();
+	const Token& token = consume();
 
-	auto reportError = [this](Token token, const std::string& message) -> void {
+	auto reportError = [this](const Token& token, const std::string& message) -> void {
 		m_job->printErrorLine(token, message.c_str());
 	};
 
@@ -213,7 +616,7 @@ Value Parser::consumeNumber()
 	}
 
 	if (fractionPosition != 0 || exponentPosition != 0) {
-		if (fractionPosition == exponentPosition - 1) {
+		if (fractionPosition != 0 && fractionPosition == exponentPosition - 1) {
 			reportError(token, "invalid exponent sign, expected number");
 			return nullptr;
 		}
@@ -224,59 +627,36 @@ Value Parser::consumeNumber()
 		}
 	}
 
+	if (m_job->rawNumbers()) {
+		Value number;
+		number.m_type = Value::Type::Number;
+		number.m_raw = true;
+		number.m_value.string = new std::string(token.symbol);
+		return number;
+	}
+
 	return std::stod(token.symbol);
 }
 
 Value Parser::consumeString()
 {
-	Token token = consume();
+	std::string string;
+	if (!consumeString(string)) {
+		return nullptr;
+	}
 
-	auto reportError = [this](Token token, const std::string& message) -> void {
-		m_job->printErrorLine(token, message.c_str());
-	};
+	return string;
+}
 
-	// FIXME: support \u Unicode character escape sequence
-	auto getPrintableString = [](char character) -> std::string {
-		if (character == '"' || character == '\\' || character == '/'
-		    || (character >= 0 && character <= 31)) {
-			switch (character) {
-			case '"':
-				return "\\\"";
-				break;
-			case '\\':
-				return "\\\\";
-				break;
-			case '/':
-				return "/";
-				break;
-			case '\b':
-				return "\\b";
-				break;
-			case '\f':
-				return "\\f";
-				break;
-			case '\n':
-				return "\\n";
-				break;
-			case '\r':
-				return "\\r";
-				break;
-			case '\t':
-				return "\\t";
-				break;
-			default:
-				char buffer[7];
-				sprintf(buffer, "\\u%.4X", character);
-				return std::string(buffer);
-				break;
-			}
-		}
+bool Parser::consumeString(std::string& output)
+{
+	const Token& token = consume();
 
-		return std::string() + character;
+	auto reportError = [this](const Token& token, const std::string& message) -> void {
+		m_job->printErrorLine(token, message.c_str());
 	};
 
-	std::string string;
-
+	// FIXME: support \u Unicode character escape sequence
 	bool escape = false;
 	for (char character : token.symbol) {
 		if (!escape) {
@@ -287,211 +667,18 @@ Value Parser::consumeString()
 
 			if (character == '"' || (character >= 0 && character <= 31)) {
 				reportError(token, "invalid string, unescaped character found");
-				return nullptr;
+				return false;
 			}
 		}
 
-		string += getPrintableString(character);
+		Serializer::appendEscaped(output, character);
 
 		if (escape) {
 			escape = false;
 		}
 	}
 
-	return string;
-}
-
-Value Parser::consumeArray()
-{
-	m_index++;
-
-	auto reportError = [this](Token token, const std::string& message) -> void {
-		m_job->printErrorLine(token, message.c_str());
-
-		// After an error, try to find the closing bracket
-		ignoreUntil(Token::Type::BracketClose);
-		m_index++;
-	};
-
-	Value array = Value::Type::Array;
-	Token token;
-	for (;;) {
-		// EOF
-		if (isEOF()) {
-			reportError(m_tokens->at(m_index - 1), "expecting closing ']' at end");
-			break;
-		}
-
-		token = peek();
-		if (token.type == Token::Type::Literal) {
-			array.emplace_back(consumeLiteral());
-		}
-		else if (token.type == Token::Type::Number) {
-			array.emplace_back(consumeNumber());
-		}
-		else if (token.type == Token::Type::String) {
-			array.emplace_back(consumeString());
-		}
-		else if (token.type == Token::Type::BracketOpen) {
-			array.emplace_back(consumeArray());
-		}
-		else if (token.type == Token::Type::BraceOpen) {
-			array.emplace_back(consumeObject());
-		}
-		else if (token.type == Token::Type::BracketClose) {
-			// Trailing comma
-			if (array.m_value.array->size() > 0) {
-				reportError(m_tokens->at(m_index - 1), "invalid comma, expecting ']'");
-				break;
-			}
-		}
-		else {
-			reportError(token, "expecting value or ']', not '" + token.symbol + "'");
-			break;
-		}
-
-		// EOF
-		if (isEOF()) {
-			reportError(token, "expecting closing ']' at end");
-			break;
-		}
-
-		// Find , or ]
-		token = consume();
-		if (token.type == Token::Type::Comma) {
-			continue;
-		}
-		else if (token.type == Token::Type::BracketClose) {
-			break;
-		}
-		else {
-			reportError(m_tokens->at(m_index - 1), "expecting comma or ']', not '" + token.symbol + "'");
-			break;
-		}
-	}
-
-	return array;
-}
-
-Value Parser::consumeObject()
-{
-	m_index++;
-
-	auto reportError = [this](Token token, const std::string& message) -> void {
-		m_job->printErrorLine(token, message.c_str());
-
-		// After an error, try to find the closing brace
-		ignoreUntil(Token::Type::BraceClose);
-		m_index++;
-	};
-
-	Value object = Value::Type::Object;
-	Token token;
-	std::string name;
-	std::map<std::string, uint8_t> unique;
-	for (;;) {
-		// EOF
-		if (isEOF()) {
-			reportError(m_tokens->at(m_index - 1), "expecting closing '}' at end");
-			break;
-		}
-
-		token = consume();
-		if (token.type == Token::Type::BraceClose) {
-			// Trailing comma
-			if (object.m_value.object->size() > 0) {
-				reportError(m_tokens->at(m_index - 1), "invalid comma, expecting '}'");
-			}
-			// Empty object
-			break;
-		}
-		if (token.type != Token::Type::String) {
-			reportError(token, "expecting string or '}', not '" + token.symbol + "'");
-			break;
-		}
-
-		// Find member name
-		m_index--;
-		Value tmpName = consumeString();
-		if (tmpName.m_type != Value::Type::String) {
-			ignoreUntil(Token::Type::BraceClose);
-			m_index++;
-			break;
-		}
-
-		// Check if name exists in hashmap
-		name = *tmpName.m_value.string;
-		if (unique.find(name) != unique.end()) {
-			reportError(token, "duplicate name '" + token.symbol + "', names should be unique");
-			break;
-		}
-		// Add name to hashmap
-		unique.insert({ name, 0 });
-
-		// EOF
-		if (isEOF()) {
-			reportError(token, "expecting colon, not 'EOF'");
-			reportError(token, "expecting closing '}' at end");
-			break;
-		}
-
-		// Find :
-		token = consume();
-		if (token.type != Token::Type::Colon) {
-			reportError(token, "expecting colon, not '" + token.symbol + "'");
-			break;
-		}
-
-		// EOF
-		if (isEOF()) {
-			reportError(token, "expecting value, not 'EOF'");
-			reportError(token, "expecting closing '}' at end");
-			break;
-		}
-
-		// Add member (name:value pair) to object
-		token = peek();
-		if (token.type == Token::Type::Literal) {
-			object.emplace(name, consumeLiteral());
-		}
-		else if (token.type == Token::Type::Number) {
-			object.emplace(name, consumeNumber());
-		}
-		else if (token.type == Token::Type::String) {
-			object.emplace(name, consumeString());
-		}
-		else if (token.type == Token::Type::BracketOpen) {
-			object.emplace(name, consumeArray());
-		}
-		else if (token.type == Token::Type::BraceOpen) {
-			object.emplace(name, consumeObject());
-		}
-		else {
-			reportError(token, "expecting value, not '" + token.symbol + "'");
-			break;
-		}
-
-		// EOF
-		if (isEOF()) {
-			reportError(token, "expecting closing '}' at end");
-			break;
-		}
-
-		// Find , or }
-		token = consume();
-		if (token.type == Token::Type::Comma) {
-			continue;
-		}
-		else if (token.type == Token::Type::BraceClose) {
-			break;
-		}
-		else {
-			reportError(token, "expecting comma or '}', not '" + token.symbol + "'");
-			break;
-		}
-	}
-
-	return object;
+	return true;
 }
 
 } // namespace ruc::json
@@ -6,40 +6,90 @@
 
 #pragma once
 
-#include <cstddef> // size_t
+#include <cstddef>    // size_t
+#include <functional> // less
+#include <map>
+#include <memory> // shared_ptr
+#include <string>
 #include <vector>
 
 #include "ruc/json/lexer.h"
 
 namespace ruc::json {
 
+class Array;
 class Job;
+class Object;
+class Shape;
 class Value;
 
 class Parser {
+private:
+	friend class Schema;
+	friend class Tape;
+
 public:
 	Parser(Job* job);
 	virtual ~Parser();
 
 	Value parse();
 
+	// Parse into target, recycling the strings, array storage and object nodes
+	// it already holds. The parser keeps its scratch buffers between calls.
+	void parseInto(Value& target);
+
 private:
+	// Arrays of only numbers with at least this many elements are packed
+	static constexpr size_t s_packMinimum = 16;
+	// Spare nodes and per depth buffers kept between parses, beyond this they
+	// are freed
+	static constexpr size_t s_spareMaximum = 1024;
+
+	// Container that is currently being parsed
+	struct Frame {
+		Value* container { nullptr };
+		size_t count { 0 }; // Elements parsed, arrays only
+	};
+
 	bool isEOF();
-	Token peek();
-	Token consume();
-	void ignoreUntil(Token::Type type);
+	const Token& peek();
+	const Token& consume();
 
+	Value consumeValue();
+	void consumeValue(Value& target);
+	// Packs an array of only numbers, false if it has other values
+	bool consumePacked(Array& array, size_t count);
+	Value* consumeElement(Frame& frame);
+	Value* consumeMember(Frame& frame);
 	Value consumeLiteral();
 	Value consumeNumber();
 	Value consumeString();
-	Value consumeArray();
-	Value consumeObject();
+	bool consumeString(std::string& output); // Appends to output
+
+	void openContainer(Value& container);
+	void closeContainer(Frame& frame);
+	void recycleMembers(std::map<std::string, Value, std::less<>>& members);
+	void recycleNode(std::map<std::string, Value, std::less<>>::node_type&& node);
+	void shapeObject(Frame& frame);
+	void shapeMembers(Object& object, std::shared_ptr<const Shape> shape);
 
 	Job* m_job { nullptr };
 
 	size_t m_index { 0 };
 
 	std::vector<Token>* m_tokens { nullptr };
+
+	// Containers that are currently being parsed, reused between values
+	std::vector<Frame> m_stack;
+
+	// Members of the recycled objects that are being parsed, one per depth
+	std::vector<std::map<std::string, Value, std::less<>>> m_spareMembers;
+	// Members that were not reused by their own object, available to any
+	// object. Their values are cleared, so they do not keep old subtrees alive.
+	std::vector<std::map<std::string, Value, std::less<>>::node_type> m_spareNodes;
+	// Shapes of the recycled objects that are being parsed, one per depth
+	std::vector<std::shared_ptr<const Shape>> m_spareShapes;
+	std::string m_name;
 };
 
 } // namespace ruc::json
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // all_of, lower_bound, sort
+#include <cstddef>   // size_t
+#include <cstdint>   // uint32_t
+#include <string>    // stoull
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/projection.h"
+#include "ruc/json/value.h"
+#include "ruc/meta/assert.h"
+
+namespace ruc::json {
+
+static void skipWhitespace(std::string_view input, size_t& index)
+{
+	while (index < input.size()
+	       && (input[index] == ' ' || input[index] == '\t' || input[index] == '\n' || input[index] == '\r')) {
+		index++;
+	}
+}
+
+static bool skipString(std::string_view input, size_t& index)
+{
+	// Skip the opening quote
+	index++;
+
+	for (;;) {
+		index = input.find_first_of("\"\\", index);
+		if (index == std::string_view::npos) {
+			index = input.size();
+			return false;
+		}
+
+		if (input[index] == '"') {
+			index++;
+			return true;
+		}
+
+		// Skip the escaped character
+		index += 2;
+	}
+}
+
+static bool skipValue(std::string_view input, size_t& index)
+{
+	// Nesting is tracked with a counter, so skipping never recurses
+	size_t depth = 0;
+	do {
+		skipWhitespace(input, index);
+		if (index >= input.size()) {
+			return false;
+		}
+
+		switch (input[index]) {
+		case '"':
+			if (!skipString(input, index)) {
+				return false;
+			}
+			break;
+		case '{':
+		case '[':
+			depth++;
+			index++;
+			break;
+		case '}':
+		case ']':
+			if (depth == 0) {
+				return false;
+			}
+			depth--;
+			index++;
+			break;
+		case ',':
+		case ':':
+			if (depth == 0) {
+				return false;
+			}
+			index++;
+			break;
+		default: {
+			// Number or literal
+			size_t begin = index;
+			index = input.find_first_of("{}[],:\" \t\r\n", index);
+			if (index == std::string_view::npos) {
+				index = input.size();
+			}
+			if (index == begin) {
+				return false;
+			}
+			break;
+		}
+		}
+	} while (depth > 0);
+
+	return true;
+}
+
+// -----------------------------------------
+
+Projection::Projection(const std::vector<std::string>& paths)
+{
+	m_nodes.emplace_back();
+
+	for (const auto& path : paths) {
+		VERIFY(path.empty() || path[0] == '/', "invalid path '{}'", path);
+
+		uint32_t node = 0;
+		for (size_t begin = 1; begin <= path.size() && !path.empty();) {
+			size_t end = std::min(path.find('/', begin), path.size());
+
+			// Decode the escape sequences ~1 and ~0
+			std::string segment;
+			for (size_t i = begin; i < end; ++i) {
+				if (path[i] == '~' && i + 1 < end && (path[i + 1] == '0' || path[i + 1] == '1')) {
+					segment += path[++i] == '0' ? '~' : '/';
+					continue;
+				}
+				segment += path[i];
+			}
+
+			node = segment == "*" ? addWildcard(node) : addMember(node, segment);
+			begin = end + 1;
+		}
+
+		m_nodes[node].terminal = true;
+	}
+
+	// A wildcard also applies to the members that are selected by name
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		uint32_t wildcard = m_nodes[i].wildcard;
+		if (wildcard == s_none) {
+			continue;
+		}
+
+		std::vector<Member> members = m_nodes[i].members;
+		for (const auto& member : members) {
+			merge(member.node, wildcard);
+		}
+	}
+
+	for (auto& node : m_nodes) {
+		std::sort(node.members.begin(), node.members.end(), [](const Member& left, const Member& right) {
+			return left.name < right.name;
+		});
+		std::sort(node.elements.begin(), node.elements.end(), [](const Element& left, const Element& right) {
+			return left.index < right.index;
+		});
+	}
+}
+
+Projection::~Projection()
+{
+}
+
+// -----------------------------------------
+
+Value Projection::parse(std::string_view input) const
+{
+	Value result;
+	size_t index = 0;
+	if (!project(input, index, 0, result)) {
+		return nullptr;
+	}
+
+	skipWhitespace(input, index);
+	if (index != input.size()) {
+		return nullptr;
+	}
+
+	return result;
+}
+
+// -----------------------------------------
+
+uint32_t Projection::addMember(uint32_t node, const std::string& name)
+{
+	for (const auto& member : m_nodes[node].members) {
+		if (member.name == name) {
+			return member.node;
+		}
+	}
+
+	uint32_t child = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.emplace_back();
+	m_nodes[node].members.push_back({ name, child });
+
+	// Numeric segments also select array elements
+	if (!name.empty() && name.size() < 20 && std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+		m_nodes[node].elements.push_back({ std::stoull(name), child });
+	}
+
+	return child;
+}
+
+uint32_t Projection::addWildcard(uint32_t node)
+{
+	if (m_nodes[node].wildcard == s_none) {
+		m_nodes[node].wildcard = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	return m_nodes[node].wildcard;
+}
+
+void Projection::merge(uint32_t target, uint32_t source)
+{
+	if (m_nodes[source].terminal) {
+		m_nodes[target].terminal = true;
+	}
+
+	// Adding nodes invalidates references, so work on a copy
+	std::vector<Member> members = m_nodes[source].members;
+	for (const auto& member : members) {
+		merge(addMember(target, member.name), member.node);
+	}
+
+	if (m_nodes[source].wildcard != s_none) {
+		merge(addWildcard(target), m_nodes[source].wildcard);
+	}
+}
+
+uint32_t Projection::findMember(const Node& node, std::string_view name) const
+{
+	auto it = std::lower_bound(node.members.begin(), node.members.end(), name, [](const Member& member, std::string_view name) {
+		return member.name < name;
+	});
+	if (it != node.members.end() && it->name == name) {
+		return it->node;
+	}
+
+	return node.wildcard;
+}
+
+uint32_t Projection::findElement(const Node& node, size_t index) const
+{
+	auto it = std::lower_bound(node.elements.begin(), node.elements.end(), index, [](const Element& element, size_t index) {
+		return element.index < index;
+	});
+	if (it != node.elements.end() && it->index == index) {
+		return it->node;
+	}
+
+	return node.wildcard;
+}
+
+// -----------------------------------------
+
+bool Projection::project(std::string_view input, size_t& index, uint32_t node, Value& target) const
+{
+	skipWhitespace(input, index);
+
+	const Node& current = m_nodes[node];
+	if (current.terminal) {
+		size_t begin = index;
+		if (!skipValue(input, index)) {
+			return false;
+		}
+		return Value::parseInto(target, input.substr(begin, index - begin));
+	}
+
+	if (index < input.size() && input[index] == '{') {
+		return projectObject(input, index, current, target);
+	}
+	if (index < input.size() && input[index] == '[') {
+		return projectArray(input, index, current, target);
+	}
+
+	// Not the container the projection expects
+	return skipValue(input, index);
+}
+
+bool Projection::projectObject(std::string_view input, size_t& index, const Node& node, Value& target) const
+{
+	index++;
+	target = Value::Type::Object;
+
+	skipWhitespace(input, index);
+	if (index < input.size() && input[index] == '}') {
+		index++;
+		return true;
+	}
+
+	for (;;) {
+		// Find member name
+		skipWhitespace(input, index);
+		if (index >= input.size() || input[index] != '"') {
+			return false;
+		}
+		size_t begin = index;
+		if (!skipString(input, index)) {
+			return false;
+		}
+		std::string_view name = input.substr(begin + 1, index - begin - 2);
+
+		// Find :
+		skipWhitespace(input, index);
+		if (index >= input.size() || input[index] != ':') {
+			return false;
+		}
+		index++;
+
+		uint32_t child = findMember(node, name);
+		if (child == s_none) {
+			if (!skipValue(input, index)) {
+				return false;
+			}
+		}
+		else {
+			// Names should be unique
+			std::string key(name);
+			if (target.exists(key) || !project(input, index, child, target[key])) {
+				return false;
+			}
+		}
+
+		// Find , or }
+		skipWhitespace(input, index);
+		if (index >= input.size()) {
+			return false;
+		}
+		char character = input[index++];
+		if (character == '}') {
+			return true;
+		}
+		if (character != ',') {
+			return false;
+		}
+	}
+}
+
+bool Projection::projectArray(std::string_view input, size_t& index, const Node& node, Value& target) const
+{
+	index++;
+	target = Value::Type::Array;
+
+	skipWhitespace(input, index);
+	if (index < input.size() && input[index] == ']') {
+		index++;
+		return true;
+	}
+
+	for (size_t i = 0;; ++i) {
+		uint32_t child = findElement(node, i);
+		if (child == s_none) {
+			if (!skipValue(input, index)) {
+				return false;
+			}
+		}
+		else {
+			// Elements in front of a selected one are kept as null
+			while (target.size() <= i) {
+				target.emplace_back(nullptr);
+			}
+			if (!project(input, index, child, target[i])) {
+				return false;
+			}
+		}
+
+		// Find , or ]
+		skipWhitespace(input, index);
+		if (index >= input.size()) {
+			return false;
+		}
+		char character = input[index++];
+		if (character == ']') {
+			return true;
+		}
+		if (character != ',') {
+			return false;
+		}
+	}
+}
+
+} // namespace ruc::json
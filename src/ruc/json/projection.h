@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+// JavaScript Object Notation (JSON) Pointer
+// https://www.rfc-editor.org/rfc/rfc6901
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <limits>  // numeric_limits
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Parses only the parts of a document that are selected by a set of paths,
+// everything else is skipped without building tokens, strings or numbers.
+//
+// Paths are JSON Pointers, a '*' segment selects every element or member.
+// Containers on the way to a selected value are kept, array elements that are
+// not selected but precede a selected one become null.
+//
+// Skipped input is only checked for balanced nesting and terminated strings.
+// Member names are compared as they appear in the input.
+class Projection {
+public:
+	Projection(const std::vector<std::string>& paths);
+	virtual ~Projection();
+
+	// Invalid input results in null, like Value::parse
+	Value parse(std::string_view input) const;
+
+private:
+	static constexpr uint32_t s_none = std::numeric_limits<uint32_t>::max();
+
+	struct Member {
+		std::string name;
+		uint32_t node { s_none };
+	};
+
+	struct Element {
+		size_t index { 0 };
+		uint32_t node { s_none };
+	};
+
+	struct Node {
+		bool terminal { false }; // Selected, the whole subtree is kept
+		uint32_t wildcard { s_none };
+		std::vector<Member> members;   // Sorted by name
+		std::vector<Element> elements; // Sorted by index
+	};
+
+	uint32_t addMember(uint32_t node, const std::string& name);
+	uint32_t addWildcard(uint32_t node);
+	void merge(uint32_t target, uint32_t source);
+
+	uint32_t findMember(const Node& node, std::string_view name) const;
+	uint32_t findElement(const Node& node, size_t index) const;
+
+	bool project(std::string_view input, size_t& index, uint32_t node, Value& target) const;
+	bool projectObject(std::string_view input, size_t& index, const Node& node, Value& target) const;
+	bool projectArray(std::string_view input, size_t& index, const Node& node, Value& target) const;
+
+	std::vector<Node> m_nodes;
+};
+
+} // namespace ruc::json
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstddef> // size_t
+#include <mutex>   // lock_guard, unique_lock
+#include <utility> // move
+
+#include "ruc/json/reclaimer.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+Reclaimer::Reclaimer(size_t maxPendingBytes)
+	: m_maxPendingBytes(maxPendingBytes)
+	, m_thread(&Reclaimer::run, this)
+{
+}
+
+Reclaimer::~Reclaimer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+// -----------------------------------------
+
+bool Reclaimer::retire(Value& value, size_t bytes)
+{
+	// Nothing on the heap worth handing off
+	if (value.type() != Value::Type::Array && value.type() != Value::Type::Object) {
+		value = nullptr;
+		return false;
+	}
+
+	if (bytes == 0) {
+		bytes = sizeof(Value) * (value.size() + 1);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_maxPendingBytes == 0 || m_pendingBytes == 0 || m_pendingBytes + bytes <= m_maxPendingBytes) {
+			m_queue.push_back({ std::move(value), bytes });
+			m_pendingBytes += bytes;
+			bytes = 0;
+		}
+	}
+
+	// Over budget
+	if (bytes > 0) {
+		value = nullptr;
+		return false;
+	}
+
+	m_wake.notify_one();
+	return true;
+}
+
+void Reclaimer::drain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_freed.wait(lock, [this]() { return m_pendingBytes == 0; });
+}
+
+size_t Reclaimer::pendingBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pendingBytes;
+}
+
+// -----------------------------------------
+
+void Reclaimer::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		m_wake.wait(lock, [this]() { return !m_queue.empty() || m_stop; });
+		if (m_queue.empty()) {
+			return;
+		}
+
+		// The tree counts as pending until it has been freed
+		Entry entry = std::move(m_queue.front());
+		m_queue.pop_front();
+
+		// Free outside of the lock, so retire() is never blocked by it
+		lock.unlock();
+		entry.value = nullptr;
+		lock.lock();
+
+		m_pendingBytes -= entry.bytes;
+		m_freed.notify_all();
+	}
+}
+
+} // namespace ruc::json
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Frees retired values on a background thread, so dropping a large document
+// does not stall the thread that drops it.
+//
+// Queued trees are bounded by a budget in bytes. Trees are not measured, as
+// that would touch every node on the calling thread, the caller passes an
+// estimate instead, like the length of the input the tree was parsed from.
+// Without one, only the top-level container is counted. A tree that does not
+// fit in the budget is freed on the calling thread, unless nothing is queued,
+// retiring never waits for the background thread.
+class Reclaimer {
+public:
+	// Budget for queued trees in bytes, 0 is unbounded
+	Reclaimer(size_t maxPendingBytes = 256 * 1024 * 1024);
+	// Frees everything that is still queued before returning
+	virtual ~Reclaimer();
+
+	// Take ownership of the tree, value is null afterwards. Returns false if
+	// the tree was freed on the calling thread
+	bool retire(Value& value, size_t bytes = 0);
+	// Block until every queued tree has been freed
+	void drain();
+
+	// Estimated size of the trees that have not been freed yet
+	size_t pendingBytes() const;
+
+private:
+	struct Entry {
+		Value value;
+		size_t bytes { 0 };
+	};
+
+	void run();
+
+	size_t m_maxPendingBytes { 0 };
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_freed;
+	std::deque<Entry> m_queue;
+	size_t m_pendingBytes { 0 };
+	bool m_stop { false };
+
+	std::thread m_thread;
+};
+
+} // namespace ruc::json
@@ -0,0 +1,996 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // find, lower_bound, sort
+#include <cmath>     // floor
+#include <cstddef>   // size_t
+#include <cstdint>   // uint8_t, uint32_t, uint64_t
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility> // move, pair
+#include <vector>
+
+#include "ruc/json/array.h"
+#include "ruc/json/job.h"
+#include "ruc/json/lexer.h"
+#include "ruc/json/object.h"
+#include "ruc/json/parser.h"
+#include "ruc/json/schema.h"
+#include "ruc/json/value.h"
+#include "ruc/meta/assert.h"
+
+namespace ruc::json {
+
+static uint8_t typeBit(Value::Type type)
+{
+	return static_cast<uint8_t>(1 << static_cast<uint8_t>(type));
+}
+
+static const char* typeName(Value::Type type)
+{
+	switch (type) {
+	case Value::Type::Null:
+		return "null";
+	case Value::Type::Bool:
+		return "boolean";
+	case Value::Type::Number:
+		return "number";
+	case Value::Type::String:
+		return "string";
+	case Value::Type::Array:
+		return "array";
+	case Value::Type::Object:
+		return "object";
+	default:
+		VERIFY_NOT_REACHED();
+		return "";
+	}
+}
+
+// Tracks the seen properties of an object, small objects dont allocate
+class PropertyBitset {
+public:
+	PropertyBitset(size_t properties)
+	{
+		size_t words = (properties + 63) / 64;
+		if (words > sizeof(m_inline) / sizeof(uint64_t)) {
+			m_heap.resize(words);
+			m_words = m_heap.data();
+		}
+	}
+
+	// Returns false if the bit was already set
+	bool set(size_t bit)
+	{
+		uint64_t mask = uint64_t { 1 } << (bit % 64);
+		bool seen = m_words[bit / 64] & mask;
+		m_words[bit / 64] |= mask;
+		return !seen;
+	}
+
+	const uint64_t* words() const { return m_words; }
+
+private:
+	uint64_t m_inline[4] {};
+	std::vector<uint64_t> m_heap;
+	uint64_t* m_words { m_inline };
+};
+
+// -----------------------------------------
+
+Schema::Schema(const Value& schema)
+{
+	compile(schema);
+}
+
+Schema::~Schema()
+{
+}
+
+// -----------------------------------------
+
+bool Schema::validate(const Value& value, std::string* error) const
+{
+	if (!valid()) {
+		if (error) {
+			*error = m_error;
+		}
+		return false;
+	}
+
+	Error result;
+	if (validateNode(0, value, error ? &result : nullptr)) {
+		return true;
+	}
+
+	if (error) {
+		*error = describe(result);
+	}
+	return false;
+}
+
+bool Schema::validate(std::string_view input, std::string* error, size_t maxDepth) const
+{
+	if (!valid()) {
+		if (error) {
+			*error = m_error;
+		}
+		return false;
+	}
+
+	Error result;
+	Error* resultPointer = error ? &result : nullptr;
+
+	Job job(input);
+	job.setMaxDepth(maxDepth);
+	Lexer lexer(&job);
+	lexer.analyze();
+
+	bool valid = job.success();
+	if (!valid) {
+		fail(resultPointer, "invalid JSON");
+	}
+
+	Parser parser(&job);
+	if (valid && parser.isEOF()) {
+		valid = failSyntax(parser, {}, "expecting token, not 'EOF'", resultPointer);
+	}
+
+	if (valid) {
+		valid = validateTokens(0, parser, 0, resultPointer);
+	}
+
+	if (valid && !parser.isEOF()) {
+		valid = failSyntax(parser, parser.peek(), "multiple root elements", resultPointer);
+	}
+
+	if (!valid && error) {
+		*error = describe(result);
+	}
+	return valid;
+}
+
+// -----------------------------------------
+
+uint32_t Schema::compile(const Value& schema)
+{
+	// Reserve the slot first, so the root always ends up at index 0
+	uint32_t index = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.emplace_back();
+
+	Node node;
+
+	if (schema.type() == Value::Type::Bool) {
+		node.types = schema.asBool() ? 0xff : 0;
+		m_nodes[index] = node;
+		return index;
+	}
+
+	if (schema.type() != Value::Type::Object) {
+		invalid("schema should be an object or boolean");
+		return index;
+	}
+
+	const Object& keywords = schema.asObject();
+	if (keywords.find("$ref") != nullptr) {
+		invalid("'$ref' is not supported");
+		return index;
+	}
+
+	auto find = [&keywords](const char* keyword) -> const Value* {
+		return keywords.find(keyword);
+	};
+
+	auto getNumber = [this, &find](const char* keyword, double& destination) -> bool {
+		const Value* value = find(keyword);
+		if (!value) {
+			return false;
+		}
+		if (value->type() != Value::Type::Number) {
+			return invalid(std::string(1, '\'').append(keyword).append("' should be a number"));
+		}
+		destination = value->asDouble();
+		return true;
+	};
+
+	auto getCount = [this, &find](const char* keyword, size_t& destination) -> void {
+		const Value* value = find(keyword);
+		if (!value) {
+			return;
+		}
+		if (value->type() != Value::Type::Number || !(value->asDouble() >= 0)) {
+			invalid(std::string(1, '\'').append(keyword).append("' should be a non-negative integer"));
+			return;
+		}
+		destination = static_cast<size_t>(value->asDouble());
+	};
+
+	// Any
+
+	if (const Value* type = find("type")) {
+		bool number = false;
+		bool integer = false;
+		auto addType = [this, &node, &number, &integer](const Value& name) {
+			if (name.type() != Value::Type::String) {
+				invalid("'type' should be a string or array of strings");
+				return;
+			}
+			const std::string& string = name.asString();
+			if (string == "null") {
+				node.types |= typeBit(Value::Type::Null);
+			}
+			else if (string == "boolean") {
+				node.types |= typeBit(Value::Type::Bool);
+			}
+			else if (string == "number") {
+				node.types |= typeBit(Value::Type::Number);
+				number = true;
+			}
+			else if (string == "integer") {
+				node.types |= typeBit(Value::Type::Number);
+				integer = true;
+			}
+			else if (string == "string") {
+				node.types |= typeBit(Value::Type::String);
+			}
+			else if (string == "array") {
+				node.types |= typeBit(Value::Type::Array);
+			}
+			else if (string == "object") {
+				node.types |= typeBit(Value::Type::Object);
+			}
+			else {
+				invalid("unknown type '" + string + "'");
+			}
+		};
+
+		node.types = 0;
+		if (type->type() == Value::Type::Array) {
+			for (const auto& name : type->asArray().elements()) {
+				addType(name);
+			}
+		}
+		else {
+			addType(*type);
+		}
+		node.integer = integer && !number;
+	}
+
+	if (const Value* enumeration = find("enum")) {
+		if (enumeration->type() != Value::Type::Array) {
+			invalid("'enum' should be an array");
+		}
+		else {
+			node.enumeration = { static_cast<uint32_t>(m_constants.size()),
+				                 static_cast<uint32_t>(enumeration->size()) };
+			for (const auto& value : enumeration->asArray().elements()) {
+				m_constants.push_back(value);
+			}
+			node.materialize = true;
+		}
+	}
+
+	if (const Value* constant = find("const")) {
+		node.constant = { static_cast<uint32_t>(m_constants.size()), 1 };
+		m_constants.push_back(*constant);
+		node.materialize = true;
+	}
+
+	if (const Value* allOf = find("allOf")) {
+		node.allOf = compileChildren(*allOf);
+		node.materialize = true;
+	}
+
+	if (const Value* anyOf = find("anyOf")) {
+		node.anyOf = compileChildren(*anyOf);
+		node.materialize = true;
+	}
+
+	if (const Value* oneOf = find("oneOf")) {
+		node.oneOf = compileChildren(*oneOf);
+		node.materialize = true;
+	}
+
+	if (const Value* negation = find("not")) {
+		node.negation = compile(*negation);
+		node.materialize = true;
+	}
+
+	// Number
+
+	getNumber("minimum", node.minimum);
+	getNumber("maximum", node.maximum);
+
+	double exclusive;
+	if (getNumber("exclusiveMinimum", exclusive) && exclusive >= node.minimum) {
+		node.minimum = exclusive;
+		node.exclusiveMinimum = true;
+	}
+	if (getNumber("exclusiveMaximum", exclusive) && exclusive <= node.maximum) {
+		node.maximum = exclusive;
+		node.exclusiveMaximum = true;
+	}
+
+	if (getNumber("multipleOf", node.multipleOf) && !(node.multipleOf > 0)) {
+		invalid("'multipleOf' should be greater than 0");
+		node.multipleOf = 0;
+	}
+
+	// String
+
+	getCount("minLength", node.minLength);
+	getCount("maxLength", node.maxLength);
+
+	// Array
+
+	if (const Value* items = find("items")) {
+		node.items = compile(*items);
+	}
+
+	if (const Value* prefixItems = find("prefixItems")) {
+		node.prefixItems = compileChildren(*prefixItems);
+	}
+
+	getCount("minItems", node.minItems);
+	getCount("maxItems", node.maxItems);
+
+	if (const Value* uniqueItems = find("uniqueItems")) {
+		if (uniqueItems->type() != Value::Type::Bool) {
+			invalid("'uniqueItems' should be a boolean");
+		}
+		else {
+			node.uniqueItems = uniqueItems->asBool();
+			node.materialize |= node.uniqueItems;
+		}
+	}
+
+	// Object
+
+	if (const Value* declared = find("properties")) {
+		if (declared->type() != Value::Type::Object) {
+			invalid("'properties' should be an object");
+		}
+		else {
+			// Members are iterated by name, so the properties end up sorted
+			std::vector<Property> properties;
+			for (const auto& [name, property] : declared->asObject().members()) {
+				properties.push_back({ name, compile(property) });
+			}
+			node.properties = { static_cast<uint32_t>(m_properties.size()),
+				                static_cast<uint32_t>(properties.size()) };
+			m_properties.insert(m_properties.end(), properties.begin(), properties.end());
+		}
+	}
+
+	// Required names are tracked on their own, they are not exempt from
+	// additionalProperties
+	if (const Value* required = find("required")) {
+		std::set<std::string> names;
+		if (required->type() != Value::Type::Array) {
+			invalid("'required' should be an array");
+		}
+		else {
+			for (const auto& name : required->asArray().elements()) {
+				if (name.type() != Value::Type::String) {
+					invalid("'required' should only contain strings");
+					continue;
+				}
+				names.insert(name.asString());
+			}
+		}
+		node.required = { static_cast<uint32_t>(m_required.size()),
+			              static_cast<uint32_t>(names.size()) };
+		m_required.insert(m_required.end(), names.begin(), names.end());
+	}
+
+	if (const Value* additionalProperties = find("additionalProperties")) {
+		node.additionalProperties = compile(*additionalProperties);
+	}
+
+	getCount("minProperties", node.minProperties);
+	getCount("maxProperties", node.maxProperties);
+
+	m_nodes[index] = node;
+	return index;
+}
+
+Schema::Range Schema::compileChildren(const Value& schemas)
+{
+	if (schemas.type() != Value::Type::Array || schemas.size() == 0) {
+		invalid("expected a non-empty array of schemas");
+		return {};
+	}
+
+	// Compile all children before storing them, as compiling a child can
+	// append to m_children as well
+	std::vector<uint32_t> children;
+	for (const auto& schema : schemas.asArray().elements()) {
+		children.push_back(compile(schema));
+	}
+
+	Range range { static_cast<uint32_t>(m_children.size()), static_cast<uint32_t>(children.size()) };
+	m_children.insert(m_children.end(), children.begin(), children.end());
+	return range;
+}
+
+bool Schema::invalid(const std::string& message)
+{
+	if (m_error.empty()) {
+		m_error = "invalid schema: " + message;
+	}
+	return false;
+}
+
+// -----------------------------------------
+
+std::string Schema::describe(const Error& error)
+{
+	// Segments were added while unwinding, so the outermost is last
+	std::string path;
+	for (auto it = error.path.rbegin(); it != error.path.rend(); ++it) {
+		path += '/';
+		path += *it;
+	}
+
+	return path.empty() ? error.message : path + ": " + error.message;
+}
+
+bool Schema::fail(Error* error, const std::string& message) const
+{
+	if (error) {
+		error->path.clear();
+		error->message = message;
+	}
+	return false;
+}
+
+bool Schema::failChild(Error* error, std::string_view segment) const
+{
+	if (!error) {
+		return false;
+	}
+
+	// JSON Pointer escapes ~ and /
+	std::string escaped;
+	escaped.reserve(segment.size());
+	for (char character : segment) {
+		if (character == '~') {
+			escaped += "~0";
+		}
+		else if (character == '/') {
+			escaped += "~1";
+		}
+		else {
+			escaped += character;
+		}
+	}
+	error->path.push_back(std::move(escaped));
+	return false;
+}
+
+bool Schema::failSyntax(Parser& parser, const Token& token, const char* message, Error* error) const
+{
+	parser.m_job->printErrorLine(token, message);
+	return fail(error, message);
+}
+
+// -----------------------------------------
+
+bool Schema::validateNode(uint32_t index, const Value& value, Error* error) const
+{
+	if (index == s_any) {
+		return true;
+	}
+
+	const Node& node = m_nodes[index];
+	if (!(node.types & typeBit(value.type()))) {
+		return fail(error, std::string("unexpected type '") + typeName(value.type()) + "'");
+	}
+
+	switch (value.type()) {
+	case Value::Type::Number:
+		if (!checkNumber(node, value.asDouble(), error)) {
+			return false;
+		}
+		break;
+	case Value::Type::String:
+		if (!checkString(node, value.asString(), error)) {
+			return false;
+		}
+		break;
+	case Value::Type::Array:
+		if (!validateArray(node, value.asArray(), error)) {
+			return false;
+		}
+		break;
+	case Value::Type::Object:
+		if (!validateObject(node, value.asObject(), error)) {
+			return false;
+		}
+		break;
+	case Value::Type::Null:
+	case Value::Type::Bool:
+	default:
+		break;
+	}
+
+	if (node.enumeration.count > 0) {
+		auto begin = m_constants.begin() + node.enumeration.begin;
+		auto end = begin + node.enumeration.count;
+		if (std::find(begin, end, value) == end) {
+			return fail(error, "value does not match any of the enumerated values");
+		}
+	}
+
+	if (node.constant.count > 0 && !(m_constants[node.constant.begin] == value)) {
+		return fail(error, "value does not match the constant value");
+	}
+
+	return validateComposition(node, value, error);
+}
+
+bool Schema::validateArray(const Node& node, const Array& array, Error* error) const
+{
+	const auto& elements = array.elements();
+	if (elements.size() < node.minItems) {
+		return fail(error, "expected at least " + std::to_string(node.minItems) + " items");
+	}
+	if (elements.size() > node.maxItems) {
+		return fail(error, "expected at most " + std::to_string(node.maxItems) + " items");
+	}
+
+	for (size_t i = 0; i < elements.size(); ++i) {
+		uint32_t child = i < node.prefixItems.count ? m_children[node.prefixItems.begin + i] : node.items;
+		if (!validateNode(child, elements[i], error)) {
+			return failChild(error, std::to_string(i));
+		}
+	}
+
+	if (node.uniqueItems && elements.size() > 1) {
+		// Only elements with an equal hash have to be compared
+		std::vector<std::pair<size_t, size_t>> hashes;
+		hashes.reserve(elements.size());
+		for (size_t i = 0; i < elements.size(); ++i) {
+			hashes.emplace_back(hash(elements[i]), i);
+		}
+		std::sort(hashes.begin(), hashes.end());
+
+		for (size_t i = 0; i < hashes.size(); ++i) {
+			for (size_t j = i + 1; j < hashes.size() && hashes[j].first == hashes[i].first; ++j) {
+				if (elements[hashes[i].second] == elements[hashes[j].second]) {
+					return fail(error, "items should be unique");
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Schema::validateObject(const Node& node, const Object& object, Error* error) const
+{
+	if (object.size() < node.minProperties) {
+		return fail(error, "expected at least " + std::to_string(node.minProperties) + " members");
+	}
+	if (object.size() > node.maxProperties) {
+		return fail(error, "expected at most " + std::to_string(node.maxProperties) + " members");
+	}
+
+	// Members, properties and required names are all sorted by name, walk them
+	// in lockstep
+	const Property* property = m_properties.data() + node.properties.begin;
+	const Property* lastProperty = property + node.properties.count;
+	const std::string* first = m_required.data() + node.required.begin;
+	const std::string* last = first + node.required.count;
+	const std::string* required = first;
+
+	PropertyBitset seen(node.required.count);
+	for (const auto& [name, member] : object.members()) {
+		while (property != lastProperty && property->name < name) {
+			++property;
+		}
+		while (required != last && *required < name) {
+			++required;
+		}
+
+		if (required != last && *required == name) {
+			seen.set(required - first);
+		}
+
+		uint32_t child = node.additionalProperties;
+		if (property != lastProperty && property->name == name) {
+			child = property->node;
+		}
+
+		if (!validateNode(child, member, error)) {
+			return failChild(error, name);
+		}
+	}
+
+	return checkRequired(node, seen.words(), error);
+}
+
+bool Schema::validateComposition(const Node& node, const Value& value, Error* error) const
+{
+	for (uint32_t i = 0; i < node.allOf.count; ++i) {
+		if (!validateNode(m_children[node.allOf.begin + i], value, error)) {
+			return false;
+		}
+	}
+
+	if (node.anyOf.count > 0) {
+		bool valid = false;
+		for (uint32_t i = 0; i < node.anyOf.count && !valid; ++i) {
+			valid = validateNode(m_children[node.anyOf.begin + i], value, nullptr);
+		}
+		if (!valid) {
+			return fail(error, "value does not match any of the 'anyOf' schemas");
+		}
+	}
+
+	if (node.oneOf.count > 0) {
+		size_t matches = 0;
+		for (uint32_t i = 0; i < node.oneOf.count && matches < 2; ++i) {
+			matches += validateNode(m_children[node.oneOf.begin + i], value, nullptr);
+		}
+		if (matches != 1) {
+			return fail(error, "value should match exactly one of the 'oneOf' schemas");
+		}
+	}
+
+	if (node.negation != s_any && validateNode(node.negation, value, nullptr)) {
+		return fail(error, "value should not match the 'not' schema");
+	}
+
+	return true;
+}
+
+// -----------------------------------------
+
+bool Schema::validateTokens(uint32_t index, Parser& parser, size_t depth, Error* error) const
+{
+	if (index == s_any) {
+		return skipTokens(parser, depth, error);
+	}
+
+	if (parser.isEOF()) {
+		return failSyntax(parser, parser.m_tokens->back(), "expecting value, not 'EOF'", error);
+	}
+
+	Token token = parser.peek();
+	bool isContainer = token.type == Token::Type::BracketOpen || token.type == Token::Type::BraceOpen;
+	size_t maxDepth = parser.m_job->maxDepth();
+	if (isContainer && maxDepth > 0 && depth >= maxDepth) {
+		return failSyntax(parser, token, "exceeded maximum nesting depth", error);
+	}
+
+	const Node& node = m_nodes[index];
+	if (node.materialize || !isContainer) {
+		// The parse counts its depth from this value
+		parser.m_job->setMaxDepth(maxDepth > 0 ? maxDepth - depth : 0);
+		Value value = parser.consumeValue();
+		parser.m_job->setMaxDepth(maxDepth);
+		if (!parser.m_job->success()) {
+			return fail(error, "invalid JSON");
+		}
+		return validateNode(index, value, error);
+	}
+
+	// Fail before walking the container
+	Value::Type type = token.type == Token::Type::BracketOpen ? Value::Type::Array : Value::Type::Object;
+	if (!(node.types & typeBit(type))) {
+		return fail(error, std::string("unexpected type '") + typeName(type) + "'");
+	}
+
+	return type == Value::Type::Array
+	           ? validateArrayTokens(node, parser, depth + 1, error)
+	           : validateObjectTokens(node, parser, depth + 1, error);
+}
+
+bool Schema::validateArrayTokens(const Node& node, Parser& parser, size_t depth, Error* error) const
+{
+	parser.m_index++;
+
+	size_t count = 0;
+	if (!parser.isEOF() && parser.peek().type == Token::Type::BracketClose) {
+		parser.m_index++;
+	}
+	else {
+		for (;;) {
+			if (count >= node.maxItems) {
+				return fail(error, "expected at most " + std::to_string(node.maxItems) + " items");
+			}
+
+			uint32_t child = count < node.prefixItems.count ? m_children[node.prefixItems.begin + count] : node.items;
+			if (!validateTokens(child, parser, depth, error)) {
+				return failChild(error, std::to_string(count));
+			}
+			count++;
+
+			// Find , or ]
+			if (parser.isEOF()) {
+				return failSyntax(parser, parser.m_tokens->back(), "expecting closing ']' at end", error);
+			}
+			Token token = parser.consume();
+			if (token.type == Token::Type::Comma) {
+				continue;
+			}
+			if (token.type == Token::Type::BracketClose) {
+				break;
+			}
+			return failSyntax(parser, token, ("expecting comma or ']', not '" + token.symbol + "'").c_str(), error);
+		}
+	}
+
+	if (count < node.minItems) {
+		return fail(error, "expected at least " + std::to_string(node.minItems) + " items");
+	}
+
+	return true;
+}
+
+bool Schema::validateObjectTokens(const Node& node, Parser& parser, size_t depth, Error* error) const
+{
+	parser.m_index++;
+
+	// Members are in document order, so binary search the sorted properties
+	// and required names
+	const Property* first = m_properties.data() + node.properties.begin;
+	const Property* last = first + node.properties.count;
+	const std::string* firstRequired = m_required.data() + node.required.begin;
+	const std::string* lastRequired = firstRequired + node.required.count;
+
+	PropertyBitset declared(node.properties.count);
+	PropertyBitset seen(node.required.count);
+	// Names that are not properties, to reject duplicates like a parse does
+	std::set<std::string, std::less<>> others;
+	size_t count = 0;
+	if (!parser.isEOF() && parser.peek().type == Token::Type::BraceClose) {
+		parser.m_index++;
+	}
+	else {
+		for (;;) {
+			Token token = parser.isEOF() ? Token {} : parser.peek();
+			std::string name;
+			if (!consumeName(parser, name, error)) {
+				return false;
+			}
+
+			if (count >= node.maxProperties) {
+				return fail(error, "expected at most " + std::to_string(node.maxProperties) + " members");
+			}
+
+			uint32_t child = node.additionalProperties;
+			const Property* property = std::lower_bound(
+				first, last, name,
+				[](const Property& property, const std::string& name) { return property.name < name; });
+			bool unique = true;
+			if (property != last && property->name == name) {
+				unique = declared.set(property - first);
+				child = property->node;
+			}
+			else {
+				unique = others.insert(name).second;
+			}
+			if (!unique) {
+				return failSyntax(parser, token, ("duplicate name '" + token.symbol + "', names should be unique").c_str(), error);
+			}
+
+			const std::string* required = std::lower_bound(firstRequired, lastRequired, name);
+			if (required != lastRequired && *required == name) {
+				seen.set(required - firstRequired);
+			}
+
+			if (!validateTokens(child, parser, depth, error)) {
+				return failChild(error, name);
+			}
+			count++;
+
+			// Find , or }
+			if (parser.isEOF()) {
+				return failSyntax(parser, parser.m_tokens->back(), "expecting closing '}' at end", error);
+			}
+			token = parser.consume();
+			if (token.type == Token::Type::Comma) {
+				continue;
+			}
+			if (token.type == Token::Type::BraceClose) {
+				break;
+			}
+			return failSyntax(parser, token, ("expecting comma or '}', not '" + token.symbol + "'").c_str(), error);
+		}
+	}
+
+	if (count < node.minProperties) {
+		return fail(error, "expected at least " + std::to_string(node.minProperties) + " members");
+	}
+
+	return checkRequired(node, seen.words(), error);
+}
+
+bool Schema::skipTokens(Parser& parser, size_t depth, Error* error) const
+{
+	// Subtrees without a schema are only checked for syntax, with an explicit
+	// stack instead of recursion so deep nesting can not overflow the call
+	// stack. Names are kept to reject duplicates, like a parse does
+
+	struct Frame {
+		bool isObject { false };
+		std::set<std::string, std::less<>> names;
+	};
+
+	size_t maxDepth = parser.m_job->maxDepth();
+	std::vector<Frame> stack;
+	for (;;) {
+		// Value
+		if (parser.isEOF()) {
+			return failSyntax(parser, parser.m_tokens->back(), "expecting value, not 'EOF'", error);
+		}
+
+		Token token = parser.peek();
+		switch (token.type) {
+		case Token::Type::Literal:
+		case Token::Type::Number:
+		case Token::Type::String:
+			parser.consumeValue();
+			if (!parser.m_job->success()) {
+				return fail(error, "invalid JSON");
+			}
+			break;
+		case Token::Type::BracketOpen:
+		case Token::Type::BraceOpen: {
+			if (maxDepth > 0 && depth + stack.size() >= maxDepth) {
+				return failSyntax(parser, token, "exceeded maximum nesting depth", error);
+			}
+			parser.m_index++;
+
+			bool isObject = token.type == Token::Type::BraceOpen;
+			Token::Type close = isObject ? Token::Type::BraceClose : Token::Type::BracketClose;
+			if (!parser.isEOF() && parser.peek().type == close) {
+				parser.m_index++;
+				break;
+			}
+
+			stack.push_back({ isObject, {} });
+			if (!isObject) {
+				continue;
+			}
+
+			std::string name;
+			if (!consumeName(parser, name, error)) {
+				return false;
+			}
+			stack.back().names.insert(std::move(name));
+			continue;
+		}
+		default:
+			return failSyntax(parser, token, ("expecting value, not '" + token.symbol + "'").c_str(), error);
+		}
+
+		// Find , or the end of the containers that are finished
+		for (;;) {
+			if (stack.empty()) {
+				return true;
+			}
+
+			Frame& frame = stack.back();
+			const char* close = frame.isObject ? "'}'" : "']'";
+			if (parser.isEOF()) {
+				return failSyntax(parser, parser.m_tokens->back(), ("expecting closing " + std::string(close) + " at end").c_str(), error);
+			}
+
+			token = parser.consume();
+			if (token.type == (frame.isObject ? Token::Type::BraceClose : Token::Type::BracketClose)) {
+				stack.pop_back();
+				continue;
+			}
+			if (token.type != Token::Type::Comma) {
+				return failSyntax(parser, token, ("expecting comma or " + std::string(close) + ", not '" + token.symbol + "'").c_str(), error);
+			}
+
+			if (frame.isObject) {
+				Token nameToken = parser.isEOF() ? Token {} : parser.peek();
+				std::string name;
+				if (!consumeName(parser, name, error)) {
+					return false;
+				}
+				if (!frame.names.insert(std::move(name)).second) {
+					return failSyntax(parser, nameToken, ("duplicate name '" + nameToken.symbol + "', names should be unique").c_str(), error);
+				}
+			}
+			break;
+		}
+	}
+}
+
+bool Schema::consumeName(Parser& parser, std::string& name, Error* error) const
+{
+	if (parser.isEOF()) {
+		return failSyntax(parser, parser.m_tokens->back(), "expecting closing '}' at end", error);
+	}
+
+	Token token = parser.peek();
+	if (token.type != Token::Type::String) {
+		return failSyntax(parser, token, ("expecting string, not '" + token.symbol + "'").c_str(), error);
+	}
+
+	Value value = parser.consumeString();
+	if (!parser.m_job->success()) {
+		return fail(error, "invalid JSON");
+	}
+	name = value.asString();
+
+	// Find :
+	if (parser.isEOF() || parser.peek().type != Token::Type::Colon) {
+		return failSyntax(parser, parser.isEOF() ? token : parser.peek(), "expecting colon", error);
+	}
+	parser.m_index++;
+
+	return true;
+}
+
+// -----------------------------------------
+
+bool Schema::checkNumber(const Node& node, double number, Error* error) const
+{
+	if (node.integer && number != std::floor(number)) {
+		return fail(error, "unexpected type 'number', expected 'integer'");
+	}
+
+	if (number < node.minimum || (node.exclusiveMinimum && number == node.minimum)) {
+		return fail(error, "number should be " + std::string(node.exclusiveMinimum ? "greater than " : "at least ")
+		                       + Value(node.minimum).dump());
+	}
+	if (number > node.maximum || (node.exclusiveMaximum && number == node.maximum)) {
+		return fail(error, "number should be " + std::string(node.exclusiveMaximum ? "less than " : "at most ")
+		                       + Value(node.maximum).dump());
+	}
+
+	if (node.multipleOf > 0) {
+		double quotient = number / node.multipleOf;
+		if (quotient != std::floor(quotient)) {
+			return fail(error, "number should be a multiple of " + Value(node.multipleOf).dump());
+		}
+	}
+
+	return true;
+}
+
+bool Schema::checkString(const Node& node, const std::string& string, Error* error) const
+{
+	if (node.minLength == 0 && node.maxLength == std::numeric_limits<size_t>::max()) {
+		return true;
+	}
+
+	// Length is measured in code points, so skip UTF-8 continuation bytes
+	size_t length = 0;
+	for (char character : string) {
+		length += (static_cast<uint8_t>(character) & 0xc0) != 0x80;
+	}
+
+	if (length < node.minLength) {
+		return fail(error, "expected at least " + std::to_string(node.minLength) + " characters");
+	}
+	if (length > node.maxLength) {
+		return fail(error, "expected at most " + std::to_string(node.maxLength) + " characters");
+	}
+
+	return true;
+}
+
+bool Schema::checkRequired(const Node& node, const uint64_t* seen, Error* error) const
+{
+	for (uint32_t i = 0; i < node.required.count; ++i) {
+		if (!(seen[i / 64] >> (i % 64) & 1)) {
+			return fail(error, "missing required member '" + m_required[node.required.begin + i] + "'");
+		}
+	}
+
+	return true;
+}
+
+} // namespace ruc::json
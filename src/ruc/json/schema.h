@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+// JSON Schema: A Media Type for Describing JSON Documents (draft 2020-12)
+// https://json-schema.org/draft/2020-12/json-schema-core.html
+// https://json-schema.org/draft/2020-12/json-schema-validation.html
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t, uint64_t
+#include <limits>  // numeric_limits
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+class Parser;
+struct Token;
+
+// Compiles a schema into a flat validation program, property lookups are
+// resolved ahead of time and required members are tracked with bitmasks.
+//
+// Supported keywords:
+// - Any:     type, enum, const, allOf, anyOf, oneOf, not
+// - Number:  minimum, maximum, exclusiveMinimum, exclusiveMaximum, multipleOf
+// - String:  minLength, maxLength
+// - Array:   items, prefixItems, minItems, maxItems, uniqueItems
+// - Object:  properties, required, additionalProperties, minProperties, maxProperties
+// Other keywords are ignored. A schema with $ref or a malformed keyword is
+// invalid, it fails every validation with the reason in error.
+class Schema {
+public:
+	Schema(const Value& schema);
+	virtual ~Schema();
+
+	bool valid() const { return m_error.empty(); }
+	// Why the schema is invalid, empty if it is valid
+	const std::string& error() const { return m_error; }
+
+	// Validation stops at the first violation, which is described in error
+	bool validate(const Value& value, std::string* error = nullptr) const;
+
+	// Validate straight from the token stream, without building a Value tree.
+	// Only subtrees constrained by enum, const, uniqueItems or a composition
+	// keyword are materialized. Nesting deeper than maxDepth is rejected, 0 is
+	// unlimited.
+	bool validate(std::string_view input, std::string* error = nullptr, size_t maxDepth = 0) const;
+
+private:
+	static constexpr uint32_t s_any = std::numeric_limits<uint32_t>::max();
+
+	struct Range {
+		uint32_t begin { 0 };
+		uint32_t count { 0 };
+	};
+
+	struct Node {
+		uint8_t types { 0xff }; // Bitmask of Value::Type
+		bool integer { false }; // Numbers have to be integral, "integer" type
+		bool materialize { false };
+		bool uniqueItems { false };
+		bool exclusiveMinimum { false };
+		bool exclusiveMaximum { false };
+
+		double minimum { -std::numeric_limits<double>::infinity() };
+		double maximum { std::numeric_limits<double>::infinity() };
+		double multipleOf { 0 };
+
+		size_t minLength { 0 };
+		size_t maxLength { std::numeric_limits<size_t>::max() };
+		size_t minItems { 0 };
+		size_t maxItems { std::numeric_limits<size_t>::max() };
+		size_t minProperties { 0 };
+		size_t maxProperties { std::numeric_limits<size_t>::max() };
+
+		uint32_t items { s_any };
+		uint32_t additionalProperties { s_any };
+		uint32_t negation { s_any };
+		Range prefixItems;  // m_children
+		Range properties;   // m_properties, sorted by name
+		Range required;     // m_required, sorted
+		Range enumeration;  // m_constants
+		Range constant;     // m_constants, one value
+		Range allOf;        // m_children
+		Range anyOf;        // m_children
+		Range oneOf;        // m_children
+	};
+
+	struct Property {
+		std::string name;
+		uint32_t node { s_any };
+	};
+
+	struct Error {
+		std::vector<std::string> path; // JSON Pointer segments, innermost first
+		std::string message;
+	};
+
+	uint32_t compile(const Value& schema);
+	Range compileChildren(const Value& schemas);
+	// Records the first reason the schema is invalid
+	bool invalid(const std::string& message);
+
+	static std::string describe(const Error& error);
+	bool fail(Error* error, const std::string& message) const;
+	bool failChild(Error* error, std::string_view segment) const;
+	bool failSyntax(Parser& parser, const Token& token, const char* message, Error* error) const;
+
+	bool validateNode(uint32_t index, const Value& value, Error* error) const;
+	bool validateArray(const Node& node, const Array& array, Error* error) const;
+	bool validateObject(const Node& node, const Object& object, Error* error) const;
+	bool validateComposition(const Node& node, const Value& value, Error* error) const;
+
+	// Depth is the number of containers around the value
+	bool validateTokens(uint32_t index, Parser& parser, size_t depth, Error* error) const;
+	bool validateArrayTokens(const Node& node, Parser& parser, size_t depth, Error* error) const;
+	bool validateObjectTokens(const Node& node, Parser& parser, size_t depth, Error* error) const;
+	bool skipTokens(Parser& parser, size_t depth, Error* error) const;
+	bool consumeName(Parser& parser, std::string& name, Error* error) const;
+
+	bool checkNumber(const Node& node, double number, Error* error) const;
+	bool checkString(const Node& node, const std::string& string, Error* error) const;
+	bool checkRequired(const Node& node, const uint64_t* seen, Error* error) const;
+
+	std::string m_error;
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_children;
+	std::vector<Property> m_properties;
+	std::vector<std::string> m_required;
+	std::vector<Value> m_constants;
+};
+
+} // namespace ruc::json
@@ -4,22 +4,34 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <cstdint>  // uint32_t
-#include <iterator> // next
-#include <sstream>  // ostringstream
+#include <algorithm> // max, min
+#include <charconv>  // chars_format, to_chars
+#include <cstddef>   // size_t
+#include <cstdint>   // uint32_t
+#include <iterator>  // next
 #include <string>
+#include <string_view>
+#include <thread>      // jthread, thread
+#include <type_traits> // is_same_v
+#include <utility>     // move
+#include <vector>
 
 #include "ruc/json/array.h"
 #include "ruc/json/lexer.h"
 #include "ruc/json/object.h"
+#include "ruc/json/output.h"
 #include "ruc/json/serializer.h"
 
 namespace ruc::json {
 
-Serializer::Serializer(const uint32_t indent, const char indentCharacter)
+// Containers smaller than two chunks are never split across threads
+static constexpr size_t s_minimumChunkSize = 1024;
+
+Serializer::Serializer(const uint32_t indent, const char indentCharacter, const uint32_t threads)
 	: m_indent(indent)
 	, m_indentCharacter(indentCharacter)
 	, m_compact(indent == 0)
+	, m_threads(threads != 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u))
 {
 }
 
@@ -39,117 +51,283 @@ std::string Serializer::dump(const Value& value)
 
 void Serializer::dumpHelper(const Value& value, const uint32_t indentLevel)
 {
-	switch (value.m_type) {
-	case Value::Type::Null:
-		m_output += "null";
-		break;
-	case Value::Type::Bool:
-		m_output += value.m_value.boolean ? "true" : "false";
-		break;
-	case Value::Type::Number: {
-		std::ostringstream os;
-		os << value.m_value.number;
-		m_output += os.str();
-		break;
-	}
-	case Value::Type::String:
-		m_output += "\"" + *value.m_value.string + "\"";
-		break;
-	case Value::Type::Array:
-		dumpArray(value, indentLevel);
-		break;
-	case Value::Type::Object:
-		dumpObject(value, indentLevel);
-		break;
-	default:
-		break;
+	size_t depth = m_stack.size();
+
+	const Value* current = &value;
+	uint32_t currentIndentLevel = indentLevel;
+	while (current != nullptr) {
+		switch (current->m_type) {
+		case Value::Type::Null:
+			m_output += "null";
+			break;
+		case Value::Type::Bool:
+			m_output += current->m_value.boolean ? "true" : "false";
+			break;
+		case Value::Type::Number:
+			if (current->m_raw) {
+				m_output += *current->m_value.string;
+				break;
+			}
+			dumpNumber(current->m_value.number);
+			break;
+		case Value::Type::String:
+			m_output += '"';
+			m_output += *current->m_value.string;
+			m_output += '"';
+			break;
+		case Value::Type::Array:
+		case Value::Type::Object:
+			dumpContainer(*current, currentIndentLevel);
+			break;
+		default:
+			break;
+		}
+
+		if (m_sink != nullptr && m_output.size() >= s_chunkSize) {
+			(*m_sink)(m_output);
+			m_output.clear();
+		}
+
+		// Find the next value, closing all the containers that are finished
+		current = nullptr;
+		while (current == nullptr && m_stack.size() > depth) {
+			Frame& frame = m_stack.back();
+			bool isArray = frame.container->m_type == Value::Type::Array;
+
+			if (frame.index == frame.container->size()) {
+				if (m_indent) {
+					m_output += '\n';
+					dumpIndentation(frame.indentLevel);
+				}
+				m_output += isArray ? ']' : '}';
+				if (m_cache) {
+					keepOutput(frame);
+				}
+				m_stack.pop_back();
+				continue;
+			}
+
+			if (frame.index > 0) {
+				m_output += m_indent ? ",\n" : ",";
+			}
+			dumpIndentation(frame.indentLevel + 1);
+
+			if (isArray) {
+				// Packed numbers are written without converting the array
+				const Array& array = *frame.container->m_value.array;
+				if (array.packing() != Array::Packing::None) {
+					dumpNumber(array.number(frame.index++));
+					continue;
+				}
+				current = &array.elements()[frame.index];
+			}
+			else {
+				dumpName(frame.member.name());
+				current = &frame.member.value();
+				++frame.member;
+			}
+			frame.index++;
+			currentIndentLevel = frame.indentLevel + 1;
+		}
 	}
 }
 
-void Serializer::dumpArray(const Value& value, const uint32_t indentLevel)
+void Serializer::dumpContainer(const Value& value, const uint32_t indentLevel)
 {
-	m_output += '[';
+	bool isArray = value.m_type == Value::Type::Array;
+
+	size_t start = m_output.size();
+	if (m_cache) {
+		const CachedOutput* output = isArray ? value.m_value.array->cachedOutput() : value.m_value.object->cachedOutput();
+		if (output != nullptr && output->matches(m_indent, m_indentCharacter, indentLevel)) {
+			m_output += output->text;
+			return;
+		}
+	}
+
+	m_output += isArray ? '[' : '{';
 	if (!m_compact) {
 		m_output += '\n';
 	}
 
-	// Empty Array early return
-	if (value.m_value.array->empty()) {
-		m_output += ']';
+	// Empty container early return
+	size_t size = value.size();
+	if (size == 0) {
+		m_output += isArray ? ']' : '}';
 		return;
 	}
 
-	size_t i = 0;
-	auto it = value.m_value.array->elements().cbegin();
-	if (!m_indent) {
-		for (; i < value.m_value.array->size() - 1; ++i, ++it) {
-			dumpHelper(*it, indentLevel + 1);
-			m_output += ',';
+	bool packed = isArray && value.m_value.array->packing() != Array::Packing::None;
+	if (m_threads < 2 || size / s_minimumChunkSize < 2 || packed || m_cache) {
+		Frame frame { &value, 0, {}, indentLevel, start };
+		if (!isArray) {
+			frame.member = value.m_value.object->members().begin();
 		}
-		dumpHelper(*it, indentLevel + 1);
+		m_stack.push_back(frame);
+		return;
+	}
+
+	if (isArray) {
+		dumpMembersParallel(value.m_value.array->elements().cbegin(), size, indentLevel);
 	}
 	else {
-		std::string indentation = std::string(m_indent * (indentLevel + 1), m_indentCharacter);
+		dumpMembersParallel(value.m_value.object->members().begin(), size, indentLevel);
+	}
 
-		for (; i < value.m_value.array->size() - 1; ++i, ++it) {
-			m_output += indentation;
-			dumpHelper(*it, indentLevel + 1);
-			m_output += ",\n";
-		}
-		m_output += indentation;
-		dumpHelper(*it, indentLevel + 1);
+	if (m_indent) {
 		m_output += '\n';
-
-		// Append indentation
-		m_output += std::string(m_indent * indentLevel, m_indentCharacter);
+		dumpIndentation(indentLevel);
 	}
-
-	m_output += "]";
+	m_output += isArray ? ']' : '}';
 }
 
-void Serializer::dumpObject(const Value& value, const uint32_t indentLevel)
+void Serializer::keepOutput(const Frame& frame)
 {
-	m_output += '{';
-	if (!m_compact) {
-		m_output += '\n';
+	size_t size = m_output.size() - frame.start;
+	if (size < s_cacheMinimum) {
+		return;
 	}
 
-	// Empty Object early return
-	if (value.m_value.object->empty()) {
-		m_output += '}';
+	const Value& container = *frame.container;
+	if (container.m_type == Value::Type::Array ? container.m_value.array->lent() : container.m_value.object->lent()) {
 		return;
 	}
 
-	size_t i = 0;
-	auto it = value.m_value.object->members().cbegin();
-	if (!m_indent) {
-		for (; i < value.m_value.object->size() - 1; ++i, ++it) {
-			m_output += '"' + it->first + "\":";
-			dumpHelper(it->second, indentLevel + 1);
-			m_output += ',';
-		}
-		m_output += '"' + it->first + "\":";
-		dumpHelper(it->second, indentLevel + 1);
+	CachedOutput output { m_indent, m_indentCharacter, frame.indentLevel, m_output.substr(frame.start, size) };
+	if (frame.container->m_type == Value::Type::Array) {
+		frame.container->m_value.array->setCachedOutput(std::move(output));
 	}
 	else {
-		std::string indentation = std::string(m_indent * (indentLevel + 1), m_indentCharacter);
+		frame.container->m_value.object->setCachedOutput(std::move(output));
+	}
+}
+
+void Serializer::dumpNumber(double number)
+{
+	appendNumber(m_output, number);
+}
+
+void Serializer::dumpName(const std::string& name)
+{
+	m_output += '"';
+	m_output += name;
+	m_output += m_indent ? "\": " : "\":";
+}
+
+void Serializer::dumpIndentation(const uint32_t indentLevel)
+{
+	m_output.append(m_indent * indentLevel, m_indentCharacter);
+}
+
+// ------------------------------------------
+
+void Serializer::appendNumber(std::string& output, double number)
+{
+	// Same as the default stream formatting, without the stream
+	char buffer[32];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), number, std::chars_format::general, 6);
+	output.append(buffer, result.ptr);
+}
+
+void Serializer::appendEscaped(std::string& output, char character)
+{
+	if (character != '"' && character != '\\' && (character < 0 || character > 31)) {
+		output += character;
+		return;
+	}
+
+	switch (character) {
+	case '"':
+		output += "\\\"";
+		break;
+	case '\\':
+		output += "\\\\";
+		break;
+	case '\b':
+		output += "\\b";
+		break;
+	case '\f':
+		output += "\\f";
+		break;
+	case '\n':
+		output += "\\n";
+		break;
+	case '\r':
+		output += "\\r";
+		break;
+	case '\t':
+		output += "\\t";
+		break;
+	default: {
+		const char* hex = "0123456789ABCDEF";
+		output += "\\u00";
+		output += hex[character >> 4];
+		output += hex[character & 0xf];
+		break;
+	}
+	}
+}
+
+// ------------------------------------------
+
+template<typename Iterator>
+void Serializer::dumpMembersParallel(Iterator begin, size_t size, const uint32_t indentLevel)
+{
+	size_t chunks = std::min(static_cast<size_t>(m_threads), size / s_minimumChunkSize);
+
+	// Split the container into ranges, each serialized by its own thread into
+	// a separate buffer, the buffers are concatenated in order afterwards.
+	// Threads join when destroyed, also if starting one or serializing throws
+	std::vector<Serializer> serializers(chunks, Serializer(m_indent, m_indentCharacter));
+	std::vector<std::jthread> threads;
+	threads.reserve(chunks - 1);
 
-		for (; i < value.m_value.object->size() - 1; ++i, ++it) {
-			m_output += indentation;
-			m_output += '"' + it->first + "\": ";
-			dumpHelper(it->second, indentLevel + 1);
-			m_output += ",\n";
+	size_t chunkSize = (size + chunks - 1) / chunks;
+	for (size_t i = 0; i < chunks; ++i) {
+		size_t count = std::min(chunkSize, size - i * chunkSize);
+		Iterator end = std::next(begin, count);
+
+		if (i == chunks - 1) {
+			serializers[i].dumpMembersRange(begin, end, indentLevel);
 		}
-		m_output += indentation;
-		m_output += '"' + it->first + "\": ";
-		dumpHelper(it->second, indentLevel + 1);
-		m_output += '\n';
+		else {
+			threads.emplace_back([&serializer = serializers[i], begin, end, indentLevel]() {
+				serializer.dumpMembersRange(begin, end, indentLevel);
+			});
+		}
+
+		begin = end;
+	}
 
-		// Append indentation
-		m_output += std::string(m_indent * indentLevel, m_indentCharacter);
+	for (auto& thread : threads) {
+		thread.join();
 	}
 
-	m_output += '}';
+	for (size_t i = 0; i < chunks; ++i) {
+		if (i > 0) {
+			m_output += m_indent ? ",\n" : ",";
+		}
+		m_output += serializers[i].m_output;
+	}
+}
+
+template<typename Iterator>
+void Serializer::dumpMembersRange(Iterator begin, Iterator end, const uint32_t indentLevel)
+{
+	for (auto it = begin; it != end; ++it) {
+		if (it != begin) {
+			m_output += m_indent ? ",\n" : ",";
+		}
+		dumpIndentation(indentLevel + 1);
+
+		if constexpr (std::is_same_v<typename Iterator::value_type, Value>) {
+			dumpHelper(*it, indentLevel + 1);
+		}
+		else {
+			dumpName(it.name());
+			dumpHelper(it.value(), indentLevel + 1);
+		}
+	}
 }
 
 } // namespace ruc::json
@@ -6,30 +6,86 @@
 
 #pragma once
 
-#include <cstdint> // uint32_t
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t
+#include <functional> // function
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "ruc/json/object.h"
 #include "ruc/json/value.h"
 
 namespace ruc::json {
 
 class Serializer {
+private:
+	friend class Transcoder;
+	friend class Writer;
+
 public:
-	Serializer(const uint32_t indent = 0, const char indentCharacter = ' ');
+	// Threads: 1 is sequential, 0 uses all available hardware threads
+	Serializer(const uint32_t indent = 0, const char indentCharacter = ' ', const uint32_t threads = 1);
 	virtual ~Serializer();
 
 	std::string dump(const Value& value);
 
+	// Containers keep their output and write it again until they are modified,
+	// so dumping again costs about as much as what changed. Containers that
+	// handed out a mutable reference to an element are written every time, as
+	// writes through the reference can happen at any later point, only their
+	// untouched elements are reused. Keeping output is not synchronized. Each
+	// container holds a copy of its own output, so memory grows with the
+	// nesting depth
+	void setCache(bool cache) { m_cache = cache; }
+
+	// Formatting shared with Writer. Parsed strings are stored the way they are
+	// written, so the parser escapes their characters with this as well
+	static void appendNumber(std::string& output, double number);
+	static void appendEscaped(std::string& output, char character);
+
 private:
+	// Smaller containers are cheaper to write again than to keep
+	static constexpr size_t s_cacheMinimum = 128;
+
+	// Container that is currently being serialized
+	struct Frame {
+		const Value* container { nullptr };
+		size_t index { 0 };
+		Members::Iterator member {};
+		uint32_t indentLevel { 0 };
+		size_t start { 0 }; // Offset of the container in the output
+	};
+
+	// Smaller output is not worth handing to the sink
+	static constexpr size_t s_chunkSize = 64 * 1024;
+
 	void dumpHelper(const Value& value, const uint32_t indentLevel = 0);
-	void dumpArray(const Value& value, const uint32_t indentLevel = 0);
-	void dumpObject(const Value& value, const uint32_t indentLevel = 0);
+	void dumpContainer(const Value& value, const uint32_t indentLevel);
+	void keepOutput(const Frame& frame);
+	void dumpNumber(double number);
+	void dumpName(const std::string& name);
+	void dumpIndentation(const uint32_t indentLevel);
+
+	template<typename Iterator>
+	void dumpMembersParallel(Iterator begin, size_t size, const uint32_t indentLevel);
+	template<typename Iterator>
+	void dumpMembersRange(Iterator begin, Iterator end, const uint32_t indentLevel);
 
 	std::string m_output;
 
 	uint32_t m_indent { 0 };
 	char m_indentCharacter { ' ' };
 	bool m_compact { true };
+	uint32_t m_threads { 1 };
+	bool m_cache { false };
+
+	// Set by Writer, hands the output over in chunks while dumping. Kept
+	// output refers to earlier offsets, so this is not used with the cache
+	const std::function<void(std::string_view)>* m_sink { nullptr };
+
+	// Containers are serialized with an explicit stack instead of recursion
+	std::vector<Frame> m_stack;
 };
 
 } // namespace ruc::json
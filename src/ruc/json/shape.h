@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm> // lower_bound
+#include <cstddef>   // size_t
+#include <limits>    // numeric_limits
+#include <string>
+#include <string_view>
+#include <utility> // move
+#include <vector>
+
+namespace ruc::json {
+
+// Member names that are shared by objects with the same keys, like the records
+// in an array. Shaped objects only store their values, at the slot of the name.
+class Shape {
+public:
+	static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+	// Names should be sorted and unique
+	explicit Shape(std::vector<std::string> names)
+		: m_names(std::move(names))
+	{
+	}
+
+	// Slot of the member with this name, npos if there is none
+	size_t find(std::string_view name) const
+	{
+		auto it = std::lower_bound(m_names.begin(), m_names.end(), name);
+		return it != m_names.end() && *it == name ? static_cast<size_t>(it - m_names.begin()) : npos;
+	}
+
+	size_t size() const { return m_names.size(); }
+	const std::vector<std::string>& names() const { return m_names; }
+
+private:
+	std::vector<std::string> m_names;
+};
+
+} // namespace ruc::json
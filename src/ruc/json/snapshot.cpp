@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstddef>    // offsetof, size_t
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstring>    // memcmp, memcpy
+#include <fcntl.h>    // open
+#include <fstream>    // ofstream
+#include <string>
+#include <string_view>
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+#include <utility>    // exchange
+
+#include "ruc/json/snapshot.h"
+#include "ruc/json/tape.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+static constexpr char s_magic[8] = { 'R', 'U', 'C', 'J', 'S', 'O', 'N', '\0' };
+static constexpr uint32_t s_version = 2;
+static constexpr uint32_t s_byteOrder = 0x01020304;
+
+// Null word, the root of an invalid snapshot
+static constexpr uint64_t s_null[1] = { 0 };
+
+struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t words;   // Number of tape words, directly after the header
+	uint64_t strings; // Size of the string buffer, directly after the words
+};
+
+static_assert(sizeof(Header) % sizeof(uint64_t) == 0, "words should stay aligned");
+
+// -----------------------------------------
+
+Snapshot::Snapshot()
+{
+}
+
+Snapshot::Snapshot(Snapshot&& other) noexcept
+	: m_mapping(std::exchange(other.m_mapping, nullptr))
+	, m_size(std::exchange(other.m_size, 0))
+{
+}
+
+Snapshot& Snapshot::operator=(Snapshot&& other) noexcept
+{
+	if (this != &other) {
+		unmap();
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+
+	return *this;
+}
+
+Snapshot::~Snapshot()
+{
+	unmap();
+}
+
+// -----------------------------------------
+
+bool Snapshot::write(const Tape& tape, std::string_view path)
+{
+	const auto& words = tape.words();
+	const auto& strings = tape.strings();
+
+	Header header {};
+	std::memcpy(header.magic, s_magic, sizeof(s_magic));
+	header.version = s_version;
+	header.byteOrder = s_byteOrder;
+	header.words = words.size();
+	header.strings = strings.size();
+
+	std::ofstream file(std::string(path), std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+	file.write(strings.data(), strings.size());
+	file.close();
+
+	return !file.fail();
+}
+
+bool Snapshot::write(const Value& value, std::string_view path)
+{
+	return write(Tape::fromValue(value), path);
+}
+
+Snapshot Snapshot::load(std::string_view path)
+{
+	Snapshot snapshot;
+
+	int fd = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return snapshot;
+	}
+
+	struct stat status;
+	if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header)) {
+		close(fd);
+		return snapshot;
+	}
+
+	size_t size = status.st_size;
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return snapshot;
+	}
+
+	snapshot.m_mapping = mapping;
+	snapshot.m_size = size;
+
+	// Only the header is read, pages of the tape are faulted in on first access
+	Header header;
+	std::memcpy(&header, mapping, sizeof(header));
+	bool valid = std::memcmp(header.magic, s_magic, sizeof(s_magic)) == 0
+	             && header.version == s_version
+	             && header.byteOrder == s_byteOrder
+	             && header.words > 0
+	             && header.words <= (size - sizeof(Header)) / sizeof(uint64_t)
+	             && header.strings == size - sizeof(Header) - header.words * sizeof(uint64_t);
+	if (!valid) {
+		snapshot.unmap();
+	}
+
+	return snapshot;
+}
+
+// -----------------------------------------
+
+TapeValue Snapshot::root() const
+{
+	if (m_mapping == nullptr) {
+		return TapeValue(s_null, nullptr, 0);
+	}
+
+	const char* image = static_cast<const char*>(m_mapping);
+	uint64_t words;
+	std::memcpy(&words, image + offsetof(Header, words), sizeof(words));
+
+	const uint64_t* tape = reinterpret_cast<const uint64_t*>(image + sizeof(Header));
+	return TapeValue(tape, image + sizeof(Header) + words * sizeof(uint64_t), 0);
+}
+
+// -----------------------------------------
+
+void Snapshot::unmap()
+{
+	if (m_mapping != nullptr) {
+		munmap(m_mapping, m_size);
+	}
+
+	m_mapping = nullptr;
+	m_size = 0;
+}
+
+} // namespace ruc::json
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <string_view>
+
+#include "ruc/json/tape.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Precompiled document that is loaded by mapping a file into memory. The image
+// is a header followed by the words and string buffer of a Tape, which only
+// hold offsets and no pointers, so it can be used in place without parsing.
+//
+// The header is checked when loading, the tape itself is trusted. Images use
+// the byte order of the machine that wrote them and are rejected elsewhere.
+class Snapshot {
+public:
+	Snapshot();
+	Snapshot(Snapshot&& other) noexcept;
+	Snapshot& operator=(Snapshot&& other) noexcept;
+	Snapshot(const Snapshot&) = delete;
+	Snapshot& operator=(const Snapshot&) = delete;
+	virtual ~Snapshot();
+
+	// Returns false if the file could not be written
+	static bool write(const Tape& tape, std::string_view path);
+	static bool write(const Value& value, std::string_view path);
+
+	// Missing files and invalid images result in an invalid snapshot with a
+	// null root
+	static Snapshot load(std::string_view path);
+
+	bool valid() const { return m_mapping != nullptr; }
+	TapeValue root() const;
+
+	// Size of the image in bytes
+	size_t size() const { return m_size; }
+
+private:
+	void unmap();
+
+	void* m_mapping { nullptr };
+	size_t m_size { 0 };
+};
+
+} // namespace ruc::json
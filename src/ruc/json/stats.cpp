@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // max
+#include <cstddef>   // size_t
+#include <cstdint>   // int64_t
+#include <memory>    // shared_ptr
+#include <string>
+#include <unordered_set>
+#include <utility> // pair
+#include <vector>
+
+#include "ruc/json/array.h"
+#include "ruc/json/object.h"
+#include "ruc/json/output.h"
+#include "ruc/json/shape.h"
+#include "ruc/json/stats.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Red-black tree node: color, parent, left and right, followed by the member
+static constexpr size_t s_memberNodeSize = 4 * sizeof(void*) + sizeof(std::pair<const std::string, Value>);
+
+// Heap bytes of the characters, 0 if they fit in the small string buffer
+static size_t stringHeapBytes(const std::string& string)
+{
+	static const size_t smallCapacity = std::string().capacity();
+	return string.capacity() > smallCapacity ? string.capacity() + 1 : 0;
+}
+
+// -----------------------------------------
+
+Value ParseStats::toValue() const
+{
+	Value json;
+	json["bytes"] = bytes;
+	json["tokens"] = tokens;
+	json["lexNanoseconds"] = lexNanoseconds;
+	json["parseNanoseconds"] = parseNanoseconds;
+	json["nodes"]["null"] = nulls;
+	json["nodes"]["bool"] = bools;
+	json["nodes"]["number"] = numbers;
+	json["nodes"]["string"] = strings;
+	json["nodes"]["array"] = arrays;
+	json["nodes"]["object"] = objects;
+	json["maxDepth"] = maxDepth;
+	json["allocations"] = allocations;
+	json["memoryUsage"] = memoryUsage;
+	return json;
+}
+
+// -----------------------------------------
+
+ParseStats measure(const Value& value)
+{
+	ParseStats stats;
+
+	auto addString = [&stats](const std::string& string) {
+		size_t bytes = stringHeapBytes(string);
+		stats.allocations += bytes > 0;
+		stats.memoryUsage += bytes;
+	};
+
+	// Text kept by a cached dump
+	auto addOutput = [&stats, &addString](const CachedOutput* output) {
+		if (output != nullptr) {
+			stats.allocations++;
+			stats.memoryUsage += sizeof(CachedOutput);
+			addString(output->text);
+		}
+	};
+
+	std::unordered_set<const Shape*> shapes;
+	std::vector<std::pair<const Value*, size_t>> stack { { &value, 0 } };
+	while (!stack.empty()) {
+		auto [current, depth] = stack.back();
+		stack.pop_back();
+
+		switch (current->type()) {
+		case Value::Type::Null:
+			stats.nulls++;
+			break;
+		case Value::Type::Bool:
+			stats.bools++;
+			break;
+		case Value::Type::Number:
+			stats.numbers++;
+			// Raw numbers keep their text in a string
+			if (!current->rawNumber().empty()) {
+				stats.allocations++;
+				stats.memoryUsage += sizeof(std::string);
+				addString(current->asString());
+			}
+			break;
+		case Value::Type::String:
+			stats.strings++;
+			stats.allocations++;
+			stats.memoryUsage += sizeof(std::string);
+			addString(current->asString());
+			break;
+		case Value::Type::Array: {
+			const Array& array = current->asArray();
+			stats.arrays++;
+			stats.maxDepth = std::max(stats.maxDepth, depth + 1);
+			addOutput(array.cachedOutput());
+
+			// Packed numbers live in one more allocation, next to their buffer
+			if (array.packing() != Array::Packing::None) {
+				stats.numbers += array.size();
+				stats.allocations += 3;
+				stats.memoryUsage += sizeof(Array) + sizeof(std::vector<int64_t>) + sizeof(std::vector<double>) + sizeof(Array::Packing)
+				                     + array.size() * sizeof(double);
+				break;
+			}
+
+			const auto& elements = array.elements();
+			stats.allocations += 1 + (elements.capacity() > 0);
+			stats.memoryUsage += sizeof(Array) + elements.capacity() * sizeof(Value);
+			for (const auto& element : elements) {
+				stack.push_back({ &element, depth + 1 });
+			}
+			break;
+		}
+		case Value::Type::Object: {
+			const Object& object = current->asObject();
+			stats.objects++;
+			stats.maxDepth = std::max(stats.maxDepth, depth + 1);
+			addOutput(object.cachedOutput());
+			stats.allocations++;
+			stats.memoryUsage += sizeof(Object);
+
+			// Shaped objects only store their values, shared names are counted once
+			const Shape* shape = object.shape();
+			if (shape != nullptr) {
+				// The shape pointer and the value storage live in one more allocation
+				stats.allocations += 1 + !object.empty();
+				stats.memoryUsage += sizeof(std::shared_ptr<const Shape>) + sizeof(std::vector<Value>) + object.size() * sizeof(Value);
+				if (shapes.insert(shape).second) {
+					stats.allocations += 2;
+					stats.memoryUsage += sizeof(Shape) + shape->names().capacity() * sizeof(std::string);
+					for (const auto& name : shape->names()) {
+						addString(name);
+					}
+				}
+			}
+			else {
+				stats.allocations += object.size();
+				stats.memoryUsage += object.size() * s_memberNodeSize;
+			}
+
+			for (const auto& [name, member] : object.members()) {
+				if (shape == nullptr) {
+					addString(name);
+				}
+				stack.push_back({ &member, depth + 1 });
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	return stats;
+}
+
+} // namespace ruc::json
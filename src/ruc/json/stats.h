@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+
+namespace ruc::json {
+
+class Value;
+
+// Where the time of a parse went and what the resulting value looks like.
+// Counting is opt-in, see Job::setCollectStats()
+struct ParseStats {
+	Value toValue() const;
+
+	// Input, only filled in by a parse
+	size_t bytes { 0 };
+	size_t tokens { 0 };
+	uint64_t lexNanoseconds { 0 };
+	uint64_t parseNanoseconds { 0 };
+
+	// Nodes per type
+	size_t nulls { 0 };
+	size_t bools { 0 };
+	size_t numbers { 0 };
+	size_t strings { 0 };
+	size_t arrays { 0 };
+	size_t objects { 0 };
+
+	size_t maxDepth { 0 };    // Container nesting, 0 for a scalar
+	size_t allocations { 0 }; // Heap blocks held by the value
+	size_t memoryUsage { 0 }; // Heap bytes held by the value
+};
+
+// Walk the value and fill in the node counts, depth and heap usage
+ParseStats measure(const Value& value);
+
+} // namespace ruc::json
@@ -0,0 +1,816 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>  // adjacent_find, min, sort
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstring>    // memcpy
+#include <functional> // hash
+#include <limits>     // numeric_limits
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility> // pair
+#include <vector>
+
+#include "ruc/json/array.h"
+#include "ruc/json/job.h"
+#include "ruc/json/lexer.h"
+#include "ruc/json/object.h"
+#include "ruc/json/parser.h"
+#include "ruc/json/tape.h"
+#include "ruc/json/value.h"
+#include "ruc/meta/assert.h"
+
+namespace ruc::json {
+
+using Tag = detail::TapeTag;
+
+static constexpr uint64_t s_payloadMask = (1ull << 56) - 1;
+static constexpr uint64_t s_endMask = detail::s_tapeEndMask;
+static constexpr uint64_t s_countMask = detail::s_tapeCountMask;
+
+static uint64_t encode(Tag tag, uint64_t payload = 0)
+{
+	return detail::encodeTapeWord(tag, payload);
+}
+
+static Tag tagOf(uint64_t word)
+{
+	return static_cast<Tag>(word >> 56);
+}
+
+// Child of a container as compared when deduplicating, the index is moved past
+// it. Children that could be shared are compared by the index of their first
+// copy, which a reference to it also points to
+static std::pair<uint64_t, uint64_t> canonical(const std::vector<uint64_t>& words, size_t& index)
+{
+	uint64_t word = words[index];
+	switch (tagOf(word)) {
+	case Tag::Number:
+		index += 2;
+		return { word, words[index - 1] };
+	case Tag::Array:
+	case Tag::Object: {
+		size_t end = word & s_endMask;
+		word = end - index > 1 ? encode(Tag::Reference, index) : word & ~s_endMask;
+		index = end;
+		return { word, 0 };
+	}
+	default:
+		index += 1;
+		return { word, 0 };
+	}
+}
+
+// Strings and small containers seen so far, by the hash of their contents
+struct Tape::Sharing {
+	DedupeStats* stats { nullptr };
+	std::unordered_multimap<size_t, size_t> strings;    // Offsets
+	std::unordered_multimap<size_t, size_t> containers; // Indices
+	// Containers in the order they were stored, the ones at the back are
+	// dropped again when their parent is replaced by a reference
+	std::vector<std::pair<size_t, size_t>> stored;
+};
+
+// -----------------------------------------
+
+TapeValue::Iterator::Iterator(const uint64_t* tape, const char* strings, size_t index, bool object)
+	: m_tape(tape)
+	, m_strings(strings)
+	, m_index(index)
+	, m_object(object)
+{
+}
+
+TapeValue TapeValue::Iterator::operator*() const
+{
+	// Object members are preceded by their name
+	return TapeValue(m_tape, m_strings, m_index + m_object);
+}
+
+TapeValue::Iterator& TapeValue::Iterator::operator++()
+{
+	m_index = skip(m_tape, m_index + m_object);
+	return *this;
+}
+
+std::string_view TapeValue::Iterator::name() const
+{
+	VERIFY(m_object);
+	return TapeValue(m_tape, m_strings, m_index).asString();
+}
+
+// -----------------------------------------
+
+TapeValue::TapeValue(const uint64_t* tape, const char* strings, size_t index)
+	: m_tape(tape)
+	, m_strings(strings)
+	, m_index(index)
+{
+	// Shared values are read from the copy they refer to
+	if (tagOf(tape[index]) == Tag::Reference) {
+		m_index = tape[index] & s_payloadMask;
+	}
+}
+
+bool TapeValue::exists(size_t index) const
+{
+	return index < size();
+}
+
+bool TapeValue::exists(std::string_view key) const
+{
+	VERIFY(type() == Value::Type::Object);
+	return find(key) != 0;
+}
+
+TapeValue TapeValue::operator[](size_t index) const
+{
+	VERIFY(type() == Value::Type::Array);
+
+	Iterator it = begin();
+	Iterator last = end();
+	for (; it != last && index > 0; --index) {
+		++it;
+	}
+
+	VERIFY(it != last, "index '{}' out of range", index);
+	return *it;
+}
+
+TapeValue TapeValue::operator[](std::string_view key) const
+{
+	VERIFY(type() == Value::Type::Object);
+
+	size_t index = find(key);
+	VERIFY(index != 0, "key '{}' not found", key);
+	return TapeValue(m_tape, m_strings, index);
+}
+
+TapeValue::Iterator TapeValue::begin() const
+{
+	Value::Type type = this->type();
+	VERIFY(type == Value::Type::Array || type == Value::Type::Object);
+	return Iterator(m_tape, m_strings, m_index + 1, type == Value::Type::Object);
+}
+
+TapeValue::Iterator TapeValue::end() const
+{
+	Value::Type type = this->type();
+	VERIFY(type == Value::Type::Array || type == Value::Type::Object);
+	return Iterator(m_tape, m_strings, next(), type == Value::Type::Object);
+}
+
+Value TapeValue::toValue() const
+{
+	// The tape is walked front to back, containers that are still being filled
+	// are kept on an explicit stack instead of recursing
+
+	struct Frame {
+		Value* value;
+		size_t end;
+	};
+	std::vector<Frame> stack;
+
+	Value result;
+	for (size_t index = m_index, end = next(); index < end;) {
+		Value* slot = &result;
+		if (!stack.empty()) {
+			Value& container = *stack.back().value;
+			if (container.type() == Value::Type::Array) {
+				container.emplace_back(nullptr);
+				slot = &container[container.size() - 1];
+			}
+			else {
+				slot = &container[std::string(TapeValue(m_tape, m_strings, index).asString())];
+				index++;
+			}
+		}
+
+		// Shared containers are small, copy them separately
+		if (tagOf(m_tape[index]) == Tag::Reference) {
+			*slot = TapeValue(m_tape, m_strings, index).toValue();
+			index++;
+			while (!stack.empty() && stack.back().end == index) {
+				stack.pop_back();
+			}
+			continue;
+		}
+
+		TapeValue value(m_tape, m_strings, index);
+		switch (value.type()) {
+		case Value::Type::Bool:
+			*slot = value.asBool();
+			break;
+		case Value::Type::Number:
+			*slot = value.asDouble();
+			break;
+		case Value::Type::String:
+			*slot = std::string(value.asString());
+			break;
+		case Value::Type::Array:
+		case Value::Type::Object:
+			*slot = value.type();
+			stack.push_back({ slot, value.next() });
+			break;
+		case Value::Type::Null:
+		default:
+			break;
+		}
+
+		index = value.type() == Value::Type::Array || value.type() == Value::Type::Object ? index + 1 : value.next();
+		while (!stack.empty() && stack.back().end == index) {
+			stack.pop_back();
+		}
+	}
+
+	return result;
+}
+
+// -----------------------------------------
+
+Value::Type TapeValue::type() const
+{
+	switch (tagOf(m_tape[m_index])) {
+	case Tag::True:
+	case Tag::False:
+		return Value::Type::Bool;
+	case Tag::Number:
+		return Value::Type::Number;
+	case Tag::String:
+		return Value::Type::String;
+	case Tag::Array:
+		return Value::Type::Array;
+	case Tag::Object:
+		return Value::Type::Object;
+	case Tag::Null:
+	default:
+		return Value::Type::Null;
+	}
+}
+
+size_t TapeValue::size() const
+{
+	switch (type()) {
+	case Value::Type::Null:
+		return 0;
+	case Value::Type::Array:
+	case Value::Type::Object: {
+		size_t count = (m_tape[m_index] >> 32) & s_countMask;
+		if (count < s_countMask) {
+			return count;
+		}
+
+		// Saturated count, walk the children
+		count = 0;
+		for (auto it = begin(), last = end(); it != last; ++it) {
+			count++;
+		}
+		return count;
+	}
+	case Value::Type::Bool:
+	case Value::Type::Number:
+	case Value::Type::String:
+	default:
+		return 1;
+	}
+}
+
+bool TapeValue::asBool() const
+{
+	VERIFY(type() == Value::Type::Bool);
+	return tagOf(m_tape[m_index]) == Tag::True;
+}
+
+double TapeValue::asDouble() const
+{
+	VERIFY(type() == Value::Type::Number);
+	double number;
+	std::memcpy(&number, &m_tape[m_index + 1], sizeof(number));
+	return number;
+}
+
+std::string_view TapeValue::asString() const
+{
+	VERIFY(type() == Value::Type::String);
+	const char* string = m_strings + (m_tape[m_index] & s_payloadMask);
+	uint32_t length;
+	std::memcpy(&length, string, sizeof(length));
+	return std::string_view(string + sizeof(length), length);
+}
+
+size_t TapeValue::next() const
+{
+	switch (tagOf(m_tape[m_index])) {
+	case Tag::Number:
+		return m_index + 2;
+	case Tag::Array:
+	case Tag::Object:
+		return m_tape[m_index] & s_endMask;
+	default:
+		return m_index + 1;
+	}
+}
+
+// -----------------------------------------
+
+size_t TapeValue::skip(const uint64_t* tape, size_t index)
+{
+	if (tagOf(tape[index]) == Tag::Reference) {
+		return index + 1;
+	}
+
+	return TapeValue(tape, nullptr, index).next();
+}
+
+size_t TapeValue::find(std::string_view key) const
+{
+	for (auto it = begin(), last = end(); it != last; ++it) {
+		if (it.name() == key) {
+			return (*it).m_index;
+		}
+	}
+
+	// The root is never a member
+	return 0;
+}
+
+// -----------------------------------------
+
+Tape::Tape()
+{
+}
+
+Tape::~Tape()
+{
+}
+
+// -----------------------------------------
+
+Tape Tape::parse(std::string_view input, size_t maxDepth)
+{
+	return parse(input, nullptr, maxDepth);
+}
+
+Tape Tape::parse(std::string_view input, DedupeStats& stats, size_t maxDepth)
+{
+	return parse(input, &stats, maxDepth);
+}
+
+Tape Tape::parse(std::string_view input, DedupeStats* stats, size_t maxDepth)
+{
+	Job job(input);
+	job.setMaxDepth(maxDepth);
+
+	Lexer lexer(&job);
+	lexer.analyze();
+
+	Tape tape;
+	Sharing sharing;
+	if (stats != nullptr) {
+		*stats = {};
+		sharing.stats = stats;
+		tape.m_sharing = &sharing;
+	}
+
+	if (job.success()) {
+		Parser parser(&job);
+		tape.build(parser);
+	}
+	tape.m_sharing = nullptr;
+
+	if (!job.success()) {
+		tape.m_words.assign(1, encode(Tag::Null));
+		tape.m_strings.clear();
+		if (stats != nullptr) {
+			*stats = {};
+		}
+	}
+
+	tape.m_words.shrink_to_fit();
+	tape.m_strings.shrink_to_fit();
+	if (stats != nullptr) {
+		stats->bytes = tape.m_words.size() * sizeof(uint64_t) + tape.m_strings.size();
+	}
+	return tape;
+}
+
+Tape Tape::fromValue(const Value& value)
+{
+	Tape tape;
+	std::vector<uint64_t>& words = tape.m_words;
+
+	// Containers that are currently being stored
+	struct Frame {
+		const Value* container;
+		size_t index;
+		size_t word;
+		Members::Iterator member;
+	};
+	std::vector<Frame> stack;
+
+	auto appendNumber = [&words](double number) {
+		uint64_t bits;
+		std::memcpy(&bits, &number, sizeof(bits));
+		words.push_back(encode(Tag::Number));
+		words.push_back(bits);
+	};
+
+	const Value* current = &value;
+	while (current != nullptr) {
+		switch (current->type()) {
+		case Value::Type::Null:
+			words.push_back(encode(Tag::Null));
+			break;
+		case Value::Type::Bool:
+			words.push_back(encode(current->asBool() ? Tag::True : Tag::False));
+			break;
+		case Value::Type::Number:
+			appendNumber(current->asDouble());
+			break;
+		case Value::Type::String:
+			tape.appendString(current->asString());
+			break;
+		case Value::Type::Array:
+		case Value::Type::Object: {
+			bool isArray = current->type() == Value::Type::Array;
+			words.push_back(encode(isArray ? Tag::Array : Tag::Object));
+			Frame frame { current, 0, words.size() - 1, {} };
+			if (!isArray) {
+				frame.member = current->asObject().members().begin();
+			}
+			stack.push_back(frame);
+			break;
+		}
+		default:
+			break;
+		}
+
+		// Find the next value, closing all the containers that are finished
+		current = nullptr;
+		while (current == nullptr && !stack.empty()) {
+			Frame& frame = stack.back();
+			if (frame.index == frame.container->size()) {
+				VERIFY(words.size() <= s_endMask, "document too large");
+				words[frame.word] |= std::min(static_cast<uint64_t>(frame.index), s_countMask) << 32 | words.size();
+				stack.pop_back();
+				continue;
+			}
+
+			if (frame.container->type() == Value::Type::Array) {
+				// Packed numbers are appended without converting the array
+				const Array& array = frame.container->asArray();
+				if (array.packing() != Array::Packing::None) {
+					appendNumber(array.number(frame.index++));
+					continue;
+				}
+				current = &array.elements()[frame.index];
+			}
+			else {
+				tape.appendString(frame.member.name());
+				current = &frame.member.value();
+				++frame.member;
+			}
+			frame.index++;
+		}
+	}
+
+	tape.m_words.shrink_to_fit();
+	tape.m_strings.shrink_to_fit();
+	return tape;
+}
+
+// -----------------------------------------
+
+void Tape::build(Parser& parser)
+{
+	Job* job = parser.m_job;
+	const std::vector<Token>& tokens = *parser.m_tokens;
+
+	if (tokens.empty()) {
+		job->printErrorLine({}, "expecting token, not 'EOF'");
+		return;
+	}
+
+	// Every token produces at most one word, except for a root number
+	m_words.reserve(tokens.size() + 1);
+	m_strings.reserve(job->input().size());
+
+	// Containers that are currently being built
+	struct Frame {
+		size_t index;
+		size_t count;
+	};
+	std::vector<Frame> stack;
+
+	for (;;) {
+		if (parser.isEOF()) {
+			job->printErrorLine(tokens.back(), "expecting value, not 'EOF'");
+			return;
+		}
+
+		const Token& token = tokens[parser.m_index];
+		switch (token.type) {
+		case Token::Type::Literal: {
+			Value literal = parser.consumeLiteral();
+			m_words.push_back(encode(literal.type() == Value::Type::Null ? Tag::Null
+			                         : literal.asBool()                  ? Tag::True
+			                                                             : Tag::False));
+			break;
+		}
+		case Token::Type::Number: {
+			double number = parser.consumeNumber().asDouble();
+			uint64_t bits;
+			std::memcpy(&bits, &number, sizeof(bits));
+			m_words.push_back(encode(Tag::Number));
+			m_words.push_back(bits);
+			break;
+		}
+		case Token::Type::String:
+			appendString(parser);
+			break;
+		case Token::Type::BracketOpen:
+		case Token::Type::BraceOpen: {
+			size_t maxDepth = job->maxDepth();
+			if (maxDepth > 0 && stack.size() >= maxDepth) {
+				job->printErrorLine(token, "exceeded maximum nesting depth");
+				return;
+			}
+
+			parser.m_index++;
+			bool isArray = token.type == Token::Type::BracketOpen;
+			m_words.push_back(encode(isArray ? Tag::Array : Tag::Object));
+
+			// Empty container
+			if (!parser.isEOF() && tokens[parser.m_index].type == (isArray ? Token::Type::BracketClose : Token::Type::BraceClose)) {
+				closeContainer(parser, tokens[parser.m_index++], m_words.size() - 1, 0);
+				break;
+			}
+
+			stack.push_back({ m_words.size() - 1, 0 });
+			if (!isArray && !appendName(parser)) {
+				return;
+			}
+			continue;
+		}
+		default:
+			job->printErrorLine(token, ("expecting value, not '" + token.symbol + "'").c_str());
+			return;
+		}
+
+		if (!job->success()) {
+			return;
+		}
+
+		// The value is complete, close finished containers until the next value is found
+
+		for (;;) {
+			if (stack.empty()) {
+				if (!parser.isEOF()) {
+					job->printErrorLine(tokens[parser.m_index], "multiple root elements");
+				}
+				return;
+			}
+
+			Frame& frame = stack.back();
+			frame.count++;
+
+			bool isArray = tagOf(m_words[frame.index]) == Tag::Array;
+			Token::Type close = isArray ? Token::Type::BracketClose : Token::Type::BraceClose;
+
+			// EOF
+			if (parser.isEOF()) {
+				job->printErrorLine(tokens.back(), isArray ? "expecting closing ']' at end" : "expecting closing '}' at end");
+				return;
+			}
+
+			// Find , or ] or }
+			const Token& separator = tokens[parser.m_index++];
+			if (separator.type == close) {
+				closeContainer(parser, separator, frame.index, frame.count);
+				if (!job->success()) {
+					return;
+				}
+				stack.pop_back();
+				continue;
+			}
+			if (separator.type != Token::Type::Comma) {
+				job->printErrorLine(separator, (std::string("expecting comma or '") + (isArray ? ']' : '}')
+				                                + "', not '" + separator.symbol + "'")
+				                                   .c_str());
+				return;
+			}
+
+			// Trailing comma
+			if (!parser.isEOF() && tokens[parser.m_index].type == close) {
+				job->printErrorLine(separator, isArray ? "invalid comma, expecting ']'" : "invalid comma, expecting '}'");
+				return;
+			}
+
+			if (!isArray && !appendName(parser)) {
+				return;
+			}
+			break;
+		}
+	}
+}
+
+bool Tape::appendName(Parser& parser)
+{
+	Job* job = parser.m_job;
+	const std::vector<Token>& tokens = *parser.m_tokens;
+
+	// Find member name
+	if (parser.isEOF()) {
+		job->printErrorLine(tokens.back(), "expecting string, not 'EOF'");
+		return false;
+	}
+
+	const Token& name = tokens[parser.m_index];
+	if (name.type != Token::Type::String) {
+		job->printErrorLine(name, ("expecting string or '}', not '" + name.symbol + "'").c_str());
+		return false;
+	}
+
+	appendString(parser);
+	if (!job->success()) {
+		return false;
+	}
+
+	// Find :
+	if (parser.isEOF()) {
+		job->printErrorLine(name, "expecting colon, not 'EOF'");
+		return false;
+	}
+	const Token& colon = tokens[parser.m_index++];
+	if (colon.type != Token::Type::Colon) {
+		job->printErrorLine(colon, ("expecting colon, not '" + colon.symbol + "'").c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void Tape::appendString(Parser& parser)
+{
+	size_t offset = m_strings.size();
+
+	// Reserve space for the length, which is known after decoding
+	m_strings.append(sizeof(uint32_t), '\0');
+	if (!parser.consumeString(m_strings)) {
+		return;
+	}
+
+	uint32_t length = static_cast<uint32_t>(m_strings.size() - offset - sizeof(uint32_t));
+	std::memcpy(&m_strings[offset], &length, sizeof(length));
+	m_strings += '\0';
+
+	if (m_sharing) {
+		offset = shareString(offset);
+	}
+
+	m_words.push_back(encode(Tag::String, offset));
+}
+
+void Tape::appendString(std::string_view string)
+{
+	VERIFY(string.size() <= std::numeric_limits<uint32_t>::max(), "string too large");
+
+	size_t offset = m_strings.size();
+	uint32_t length = static_cast<uint32_t>(string.size());
+	m_strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+	m_strings += string;
+	m_strings += '\0';
+
+	m_words.push_back(encode(Tag::String, offset));
+}
+
+void Tape::closeContainer(Parser& parser, const Token& token, size_t index, size_t count)
+{
+	if (m_words.size() > s_endMask) {
+		parser.m_job->printErrorLine(token, "document too large");
+		return;
+	}
+
+	m_words[index] |= std::min(static_cast<uint64_t>(count), s_countMask) << 32 | m_words.size();
+
+	// Names should be unique, compare them once the object is complete
+	if (tagOf(m_words[index]) == Tag::Object && count > 1) {
+		std::vector<std::string_view> names;
+		names.reserve(count);
+		TapeValue object(m_words.data(), m_strings.data(), index);
+		for (auto it = object.begin(), last = object.end(); it != last; ++it) {
+			names.push_back(it.name());
+		}
+
+		std::sort(names.begin(), names.end());
+		auto duplicate = std::adjacent_find(names.begin(), names.end());
+		if (duplicate != names.end()) {
+			parser.m_job->printErrorLine(token, ("duplicate name '" + std::string(*duplicate) + "', names should be unique").c_str());
+			return;
+		}
+	}
+
+	if (m_sharing) {
+		shareContainer(index);
+	}
+}
+
+size_t Tape::shareString(size_t offset)
+{
+	DedupeStats& stats = *m_sharing->stats;
+	stats.strings++;
+
+	// Compare the length as well, so a match never runs into the next string
+	std::string_view string(m_strings.data() + offset, m_strings.size() - offset);
+	size_t hash = std::hash<std::string_view> {}(string);
+
+	auto [it, last] = m_sharing->strings.equal_range(hash);
+	for (; it != last; ++it) {
+		if (m_strings.compare(it->second, string.size(), string) == 0) {
+			stats.sharedStrings++;
+			stats.savedBytes += string.size();
+			m_strings.resize(offset);
+			return it->second;
+		}
+	}
+
+	m_sharing->strings.emplace(hash, offset);
+	return offset;
+}
+
+void Tape::shareContainer(size_t index)
+{
+	// Empty containers are a single word, as small as a reference
+	size_t size = m_words.size() - index;
+	if (size < 2 || size > s_shareMaximum) {
+		return;
+	}
+
+	DedupeStats& stats = *m_sharing->stats;
+	stats.subtrees++;
+
+	// Strings are already shared, so equal containers have equal children
+	size_t hash = m_words[index] & ~s_endMask;
+	for (size_t i = index + 1; i < m_words.size();) {
+		auto [word, bits] = canonical(m_words, i);
+		hash = ((hash ^ word) * 1099511628211ull ^ bits) * 1099511628211ull;
+	}
+
+	auto& containers = m_sharing->containers;
+	auto& stored = m_sharing->stored;
+
+	auto [it, last] = containers.equal_range(hash);
+	for (; it != last; ++it) {
+		if (!equalContainers(it->second, index)) {
+			continue;
+		}
+
+		// Forget the children, their words are dropped
+		while (!stored.empty() && stored.back().second > index) {
+			auto [child, childLast] = containers.equal_range(stored.back().first);
+			for (; child != childLast; ++child) {
+				if (child->second == stored.back().second) {
+					containers.erase(child);
+					break;
+				}
+			}
+			stored.pop_back();
+		}
+
+		stats.sharedSubtrees++;
+		stats.savedBytes += (size - 1) * sizeof(uint64_t);
+		m_words.resize(index);
+		m_words.push_back(encode(Tag::Reference, it->second));
+		return;
+	}
+
+	containers.emplace(hash, index);
+	stored.push_back({ hash, index });
+}
+
+bool Tape::equalContainers(size_t left, size_t right) const
+{
+	// Children that are references take fewer words than the first copy
+	if ((m_words[left] & ~s_endMask) != (m_words[right] & ~s_endMask)) {
+		return false;
+	}
+
+	size_t leftEnd = m_words[left] & s_endMask;
+	size_t rightEnd = m_words[right] & s_endMask;
+	size_t i = left + 1;
+	size_t j = right + 1;
+	while (i < leftEnd && j < rightEnd) {
+		if (canonical(m_words, i) != canonical(m_words, j)) {
+			return false;
+		}
+	}
+
+	return i == leftEnd && j == rightEnd;
+}
+
+} // namespace ruc::json
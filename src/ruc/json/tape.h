@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint64_t
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+class Parser;
+struct Token;
+
+namespace detail {
+
+// Word encoding of a tape, see Tape. Shared with documents from _jsondoc literals
+enum class TapeTag : uint8_t {
+	Null,
+	True,
+	False,
+	Number,
+	String,
+	Array,
+	Object,
+	Reference,
+};
+
+static constexpr uint64_t s_tapeEndMask = 0xffffffff;
+static constexpr uint64_t s_tapeCountMask = 0xffffff;
+
+constexpr uint64_t encodeTapeWord(TapeTag tag, uint64_t payload = 0)
+{
+	return static_cast<uint64_t>(tag) << 56 | payload;
+}
+
+} // namespace detail
+
+// Read-only view of a value stored on a tape, cheap to copy. Views do not own
+// any memory and are only valid as long as the tape they point into.
+class TapeValue {
+public:
+	// Iterates the elements of an array or the members of an object
+	class Iterator {
+	public:
+		Iterator(const uint64_t* tape, const char* strings, size_t index, bool object);
+
+		TapeValue operator*() const;
+		Iterator& operator++();
+		bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+		bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+		// Member name, objects only
+		std::string_view name() const;
+
+	private:
+		const uint64_t* m_tape { nullptr };
+		const char* m_strings { nullptr };
+		size_t m_index { 0 };
+		bool m_object { false };
+	};
+
+	TapeValue(const uint64_t* tape, const char* strings, size_t index);
+
+	bool exists(size_t index) const;
+	bool exists(std::string_view key) const;
+
+	// Elements and members are found by skipping over their siblings
+	TapeValue operator[](size_t index) const;
+	TapeValue operator[](std::string_view key) const;
+	TapeValue at(size_t index) const { return (*this)[index]; }
+	TapeValue at(std::string_view key) const { return (*this)[key]; }
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	// Copy this value and its children into a mutable Value tree
+	Value toValue() const;
+
+	Value::Type type() const;
+	size_t size() const;
+
+	bool asBool() const;
+	double asDouble() const;
+	std::string_view asString() const;
+
+	// Index past the end of this value, for a shared value that is the end of
+	// the copy it refers to
+	size_t next() const;
+
+private:
+	size_t find(std::string_view key) const;
+	// Index past the end of the word at this index, without following references
+	static size_t skip(const uint64_t* tape, size_t index);
+
+	const uint64_t* m_tape { nullptr };
+	const char* m_strings { nullptr };
+	size_t m_index { 0 };
+};
+
+// Result of a deduplicating parse
+struct DedupeStats {
+	size_t strings { 0 };        // Strings parsed, names included
+	size_t sharedStrings { 0 };  // Strings that reuse an earlier copy
+	size_t subtrees { 0 };       // Containers small enough to be shared
+	size_t sharedSubtrees { 0 }; // Containers replaced by a reference
+	size_t bytes { 0 };          // Words and string buffer of the tape
+	size_t savedBytes { 0 };     // Avoided by sharing
+
+	// Size without sharing divided by the size with sharing
+	double ratio() const { return bytes > 0 ? static_cast<double>(bytes + savedBytes) / bytes : 1.0; }
+};
+
+// Immutable document stored as a flat tape of 64-bit words plus a string
+// buffer. Every word holds a type tag in the upper 8 bits and a payload in the
+// lower 56 bits:
+// - Number:       followed by a word containing the bits of the double
+// - String:       offset into the string buffer, which stores a 32-bit length,
+//                 the characters and a null terminator
+// - Array/Object: index past the end of the container in the lower 32 bits,
+//                 the (saturated) number of children in the next 24 bits
+// - Reference:    index of an earlier, equal container, only written by a
+//                 deduplicating parse
+// Object members are stored as a name string followed by the value, in
+// document order.
+class Tape {
+public:
+	Tape();
+	virtual ~Tape();
+
+	// Nesting deeper than maxDepth is rejected, 0 is unlimited. Invalid input
+	// results in a null document, like Value::parse
+	static Tape parse(std::string_view input, size_t maxDepth = 0);
+	// Store equal strings once and replace small containers that are equal to
+	// an earlier one by a reference to it, views resolve references themselves
+	static Tape parse(std::string_view input, DedupeStats& stats, size_t maxDepth = 0);
+	// Store an existing value, member names are already unique
+	static Tape fromValue(const Value& value);
+
+	TapeValue root() const { return TapeValue(m_words.data(), m_strings.data(), 0); }
+
+	const std::vector<uint64_t>& words() const { return m_words; }
+	const std::string& strings() const { return m_strings; }
+
+private:
+	struct Sharing;
+
+	// Containers up to this many words are hashed when deduplicating
+	static constexpr size_t s_shareMaximum = 128;
+
+	static Tape parse(std::string_view input, DedupeStats* stats, size_t maxDepth);
+
+	void build(Parser& parser);
+	bool appendName(Parser& parser);
+	void appendString(Parser& parser);
+	void appendString(std::string_view string);
+	void closeContainer(Parser& parser, const Token& token, size_t index, size_t count);
+	size_t shareString(size_t offset);
+	void shareContainer(size_t index);
+	bool equalContainers(size_t left, size_t right) const;
+
+	std::vector<uint64_t> m_words;
+	std::string m_strings;
+
+	Sharing* m_sharing { nullptr }; // Only set during a deduplicating parse
+};
+
+} // namespace ruc::json
@@ -10,8 +10,10 @@
 #include <cstdint> // int32_t, int64_t, uint32_t
 #include <map>
 #include <string>
+#include <type_traits> // is_same_v
 #include <unordered_map>
 #include <utility> // forward
+#include <vector>
 
 #include "ruc/json/array.h"
 #include "ruc/json/object.h"
@@ -20,6 +22,9 @@
 
 namespace ruc::json {
 
+template<size_t Words, size_t Strings>
+struct StaticDocument;
+
 namespace detail {
 
 struct jsonConstructor {
@@ -76,6 +81,13 @@ struct jsonConstructor {
 	{
 		json.destroy();
 		json.m_type = Json::Type::Array;
+
+		// Numbers are stored packed
+		if constexpr ((Integral<T> && !std::is_same_v<T, bool>) || FloatingPoint<T>) {
+			json.m_value.array = new Array(std::vector<double>(array.begin(), array.end()));
+			return;
+		}
+
 		json.m_value.array = new Array;
 		json.m_value.array->reserve(array.size());
 		for (const T& value : array) {
@@ -112,6 +124,13 @@ struct jsonConstructor {
 			json.m_value.object->emplace(name, value);
 		}
 	}
+
+	// Documents from _jsondoc literals, see literal.h
+	template<typename Json, size_t Words, size_t Strings>
+	static void construct(Json& json, const StaticDocument<Words, Strings>& document)
+	{
+		json = document.toValue();
+	}
 };
 
 template<typename Json, typename T>
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // count
+#include <cstddef>   // size_t
+#include <cstdint>   // uint32_t
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/job.h"
+#include "ruc/json/lexer.h"
+#include "ruc/json/transcoder.h"
+#include "ruc/json/validate.h"
+
+namespace ruc::json {
+
+static constexpr size_t s_chunkSize = 64 * 1024;
+
+Transcoder::Transcoder(const uint32_t indent, const char indentCharacter)
+	: m_serializer(indent, indentCharacter)
+{
+}
+
+Transcoder::~Transcoder()
+{
+}
+
+// -----------------------------------------
+
+bool Transcoder::transcode(std::string_view input, const Sink& sink)
+{
+	Job job(input);
+
+	SyntaxError error;
+	if (!validate(input, &error)) {
+		std::string_view before = input.substr(0, error.offset);
+		size_t line = std::count(before.begin(), before.end(), '\n');
+		size_t newline = before.rfind('\n');
+		size_t column = newline == std::string_view::npos ? error.offset : error.offset - newline - 1;
+		job.printErrorLine({ Token::Type::None, line, column, "" }, error.message);
+		return false;
+	}
+
+	std::string& output = m_serializer.m_output;
+	output.clear();
+	m_stack.clear();
+
+	// Only the current token is kept, the token buffer is cleared after each one
+	Lexer lexer(&job);
+	std::vector<Token>& tokens = *job.tokens();
+	while (lexer.next()) {
+		const Token& token = tokens.back();
+		switch (token.type) {
+		case Token::Type::BraceOpen:
+		case Token::Type::BracketOpen: {
+			beginValue();
+			bool isObject = token.type == Token::Type::BraceOpen;
+			output += isObject ? '{' : '[';
+			if (!m_serializer.m_compact) {
+				output += '\n';
+			}
+			m_stack.push_back({ isObject, isObject, 0 });
+			break;
+		}
+		case Token::Type::BraceClose:
+		case Token::Type::BracketClose:
+			if (m_stack.back().count > 0 && m_serializer.m_indent) {
+				output += '\n';
+				m_serializer.dumpIndentation(m_stack.size() - 1);
+			}
+			output += token.type == Token::Type::BraceClose ? '}' : ']';
+			m_stack.pop_back();
+			break;
+		case Token::Type::String:
+			if (!m_stack.empty() && m_stack.back().expectName) {
+				Frame& frame = m_stack.back();
+				if (frame.count > 0) {
+					output += m_serializer.m_indent ? ",\n" : ",";
+				}
+				m_serializer.dumpIndentation(m_stack.size());
+				m_serializer.dumpName(token.symbol);
+				frame.expectName = false;
+				break;
+			}
+			beginValue();
+			output += '"';
+			output += token.symbol;
+			output += '"';
+			break;
+		case Token::Type::Number:
+		case Token::Type::Literal:
+			beginValue();
+			output += token.symbol;
+			break;
+		default:
+			break;
+		}
+
+		tokens.clear();
+		flush(sink, s_chunkSize);
+	}
+
+	if (!job.success()) {
+		return false;
+	}
+
+	flush(sink, 0);
+	return true;
+}
+
+std::string Transcoder::transcode(std::string_view input)
+{
+	std::string result;
+	if (!transcode(input, [&result](std::string_view chunk) { result += chunk; })) {
+		return {};
+	}
+
+	return result;
+}
+
+// -----------------------------------------
+
+void Transcoder::beginValue()
+{
+	if (m_stack.empty()) {
+		return;
+	}
+
+	Frame& frame = m_stack.back();
+	if (frame.isObject) {
+		// The separator and indentation were written before the name
+		frame.expectName = true;
+	}
+	else {
+		if (frame.count > 0) {
+			m_serializer.m_output += m_serializer.m_indent ? ",\n" : ",";
+		}
+		m_serializer.dumpIndentation(m_stack.size());
+	}
+	frame.count++;
+}
+
+void Transcoder::flush(const Sink& sink, size_t threshold)
+{
+	std::string& output = m_serializer.m_output;
+	if (!output.empty() && output.size() >= threshold) {
+		sink(output);
+		output.clear();
+	}
+}
+
+} // namespace ruc::json
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t
+#include <functional> // function
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/serializer.h"
+
+namespace ruc::json {
+
+// Reformats JSON text without building values, member order and the original
+// number and string text are kept as-is. The layout is the same as dump() with
+// the same indentation. Tokens are lexed one at a time and output is handed to
+// the sink in chunks, so memory use only grows with the nesting depth.
+//
+// The input is validated up front, invalid input writes nothing to the sink.
+class Transcoder {
+public:
+	using Sink = std::function<void(std::string_view)>;
+
+	// Indent 0 minifies
+	Transcoder(const uint32_t indent = 0, const char indentCharacter = ' ');
+	virtual ~Transcoder();
+
+	bool transcode(std::string_view input, const Sink& sink);
+	// Empty on invalid input
+	std::string transcode(std::string_view input);
+
+private:
+	// Container that is currently being transcoded
+	struct Frame {
+		bool isObject { false };
+		bool expectName { false };
+		size_t count { 0 };
+	};
+
+	void beginValue();
+	void flush(const Sink& sink, size_t threshold);
+
+	Serializer m_serializer;
+	std::vector<Frame> m_stack;
+};
+
+} // namespace ruc::json
@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t, uint64_t
+#include <cstring> // memcpy
+#include <string_view>
+#include <vector>
+
+#include "ruc/json/validate.h"
+
+namespace ruc::json {
+
+static constexpr uint64_t s_ones = 0x0101010101010101ull;
+static constexpr uint64_t s_highs = 0x8080808080808080ull;
+
+// Whether any byte in the word is a quote, backslash, control character or not ASCII
+static bool hasSpecialByte(uint64_t word)
+{
+	auto hasZeroByte = [](uint64_t word) { return (word - s_ones) & ~word & s_highs; };
+
+	uint64_t quote = hasZeroByte(word ^ (s_ones * '"'));
+	uint64_t backslash = hasZeroByte(word ^ (s_ones * '\\'));
+	uint64_t control = (word - s_ones * 0x20) & ~word & s_highs;
+	return (quote | backslash | control | (word & s_highs)) != 0;
+}
+
+static bool isWhitespace(char character)
+{
+	return character == ' ' || character == '\t' || character == '\n' || character == '\r';
+}
+
+static bool isDigit(char character)
+{
+	return character >= '0' && character <= '9';
+}
+
+static bool isHexDigit(char character)
+{
+	return isDigit(character) || (character >= 'a' && character <= 'f') || (character >= 'A' && character <= 'F');
+}
+
+static void skipWhitespace(std::string_view input, size_t& index)
+{
+	while (index < input.size() && isWhitespace(input[index])) {
+		index++;
+	}
+}
+
+static const char* validateUtf8(std::string_view input, size_t& index)
+{
+	unsigned char character = input[index];
+
+	size_t length = 0;
+	uint32_t codepoint = 0;
+	uint32_t minimum = 0;
+	if (character >= 0xc2 && character <= 0xdf) {
+		length = 2;
+		codepoint = character & 0x1f;
+		minimum = 0x80;
+	}
+	else if ((character & 0xf0) == 0xe0) {
+		length = 3;
+		codepoint = character & 0x0f;
+		minimum = 0x800;
+	}
+	else if (character >= 0xf0 && character <= 0xf4) {
+		length = 4;
+		codepoint = character & 0x07;
+		minimum = 0x10000;
+	}
+	else {
+		return "invalid UTF-8 lead byte";
+	}
+
+	if (index + length > input.size()) {
+		return "truncated UTF-8 sequence";
+	}
+
+	for (size_t i = 1; i < length; ++i) {
+		unsigned char continuation = input[index + i];
+		if ((continuation & 0xc0) != 0x80) {
+			return "invalid UTF-8 continuation byte";
+		}
+		codepoint = codepoint << 6 | (continuation & 0x3f);
+	}
+
+	// Overlong encodings and surrogates
+	if (codepoint < minimum || codepoint > 0x10ffff || (codepoint >= 0xd800 && codepoint <= 0xdfff)) {
+		return "invalid UTF-8 code point";
+	}
+
+	index += length;
+	return nullptr;
+}
+
+static const char* validateString(std::string_view input, size_t& index)
+{
+	// Skip the opening quote
+	index++;
+
+	for (;;) {
+		// Skip plain characters a word at a time
+		while (index + sizeof(uint64_t) <= input.size()) {
+			uint64_t word;
+			std::memcpy(&word, input.data() + index, sizeof(word));
+			if (hasSpecialByte(word)) {
+				break;
+			}
+			index += sizeof(word);
+		}
+
+		if (index >= input.size()) {
+			return "strings should be wrapped in double quotes";
+		}
+
+		unsigned char character = input[index];
+		if (character == '"') {
+			index++;
+			return nullptr;
+		}
+
+		if (character == '\\') {
+			if (index + 1 >= input.size()) {
+				return "strings should be wrapped in double quotes";
+			}
+
+			switch (input[index + 1]) {
+			case '"':
+			case '\\':
+			case '/':
+			case 'b':
+			case 'f':
+			case 'n':
+			case 'r':
+			case 't':
+				index += 2;
+				break;
+			case 'u':
+				for (size_t i = 2; i < 6; ++i) {
+					if (index + i >= input.size() || !isHexDigit(input[index + i])) {
+						index += i;
+						return "invalid unicode escape, expecting 4 hex digits";
+					}
+				}
+				index += 6;
+				break;
+			default:
+				index++;
+				return "invalid escape sequence";
+			}
+			continue;
+		}
+
+		if (character < 0x20) {
+			return "invalid string, unescaped character found";
+		}
+
+		if (character < 0x80) {
+			index++;
+			continue;
+		}
+
+		if (const char* message = validateUtf8(input, index)) {
+			return message;
+		}
+	}
+}
+
+static const char* validateNumber(std::string_view input, size_t& index)
+{
+	// number = [ minus ] int [ frac ] [ exp ]
+
+	if (input[index] == '-') {
+		index++;
+	}
+
+	// int = zero / ( digit1-9 *DIGIT )
+	if (index >= input.size() || !isDigit(input[index])) {
+		return "expected number after minus";
+	}
+	if (input[index] == '0') {
+		index++;
+		if (index < input.size() && isDigit(input[index])) {
+			return "invalid leading zero";
+		}
+	}
+	else {
+		while (index < input.size() && isDigit(input[index])) {
+			index++;
+		}
+	}
+
+	// frac = decimal-point 1*DIGIT
+	if (index < input.size() && input[index] == '.') {
+		index++;
+		if (index >= input.size() || !isDigit(input[index])) {
+			return "invalid number";
+		}
+		while (index < input.size() && isDigit(input[index])) {
+			index++;
+		}
+	}
+
+	// exp = e [ minus / plus ] 1*DIGIT
+	if (index < input.size() && (input[index] == 'e' || input[index] == 'E')) {
+		index++;
+		if (index < input.size() && (input[index] == '-' || input[index] == '+')) {
+			index++;
+		}
+		if (index >= input.size() || !isDigit(input[index])) {
+			return "invalid exponent sign, expected number";
+		}
+		while (index < input.size() && isDigit(input[index])) {
+			index++;
+		}
+	}
+
+	return nullptr;
+}
+
+static const char* validateLiteral(std::string_view input, size_t& index)
+{
+	for (std::string_view literal : { "true", "false", "null" }) {
+		if (input.substr(index, literal.size()) == literal) {
+			index += literal.size();
+			return nullptr;
+		}
+	}
+
+	return "invalid literal";
+}
+
+static const char* validateName(std::string_view input, size_t& index)
+{
+	skipWhitespace(input, index);
+	if (index >= input.size() || input[index] != '"') {
+		return "expecting string";
+	}
+
+	if (const char* message = validateString(input, index)) {
+		return message;
+	}
+
+	skipWhitespace(input, index);
+	if (index >= input.size() || input[index] != ':') {
+		return "expecting colon";
+	}
+
+	index++;
+	return nullptr;
+}
+
+// -----------------------------------------
+
+bool validate(std::string_view input, SyntaxError* error)
+{
+	// Open containers as a stack of bits, set for objects. The first 4096
+	// levels are kept inline, deeper levels spill to the heap
+	static constexpr size_t inlineWords = 64;
+	uint64_t inlineStack[inlineWords];
+	std::vector<uint64_t> spilledStack;
+	size_t depth = 0;
+
+	auto word = [&](size_t level) -> uint64_t& {
+		size_t index = level / 64;
+		if (index < inlineWords) {
+			return inlineStack[index];
+		}
+		if (spilledStack.size() <= index - inlineWords) {
+			spilledStack.resize(index - inlineWords + 1);
+		}
+		return spilledStack[index - inlineWords];
+	};
+	auto push = [&](bool isObject) {
+		uint64_t& bits = word(depth);
+		uint64_t mask = 1ull << (depth % 64);
+		bits = isObject ? bits | mask : bits & ~mask;
+		depth++;
+	};
+	auto top = [&]() -> bool { return word(depth - 1) >> ((depth - 1) % 64) & 1; };
+
+	size_t index = 0;
+	auto fail = [&](const char* message) {
+		if (error != nullptr) {
+			error->offset = index;
+			error->message = message;
+		}
+		return false;
+	};
+
+	for (;;) {
+		// Value
+
+		skipWhitespace(input, index);
+		if (index >= input.size()) {
+			return fail("expecting value, not 'EOF'");
+		}
+
+		const char* message = nullptr;
+		char character = input[index];
+		switch (character) {
+		case '{':
+		case '[': {
+			bool isObject = character == '{';
+			index++;
+
+			// Empty container
+			skipWhitespace(input, index);
+			if (index < input.size() && input[index] == (isObject ? '}' : ']')) {
+				index++;
+				break;
+			}
+
+			push(isObject);
+			if (isObject && (message = validateName(input, index))) {
+				return fail(message);
+			}
+			continue;
+		}
+		case '"':
+			message = validateString(input, index);
+			break;
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			message = validateNumber(input, index);
+			break;
+		default:
+			message = character >= 'a' && character <= 'z' ? validateLiteral(input, index) : "expecting value";
+			break;
+		}
+
+		if (message != nullptr) {
+			return fail(message);
+		}
+
+		// The value is complete, close finished containers until the next value
+
+		for (;;) {
+			skipWhitespace(input, index);
+
+			if (depth == 0) {
+				return index == input.size() || fail("multiple root elements");
+			}
+
+			bool isObject = top();
+			if (index >= input.size()) {
+				return fail(isObject ? "expecting closing '}' at end" : "expecting closing ']' at end");
+			}
+
+			character = input[index];
+			if (character == (isObject ? '}' : ']')) {
+				index++;
+				depth--;
+				continue;
+			}
+			if (character != ',') {
+				return fail(isObject ? "expecting comma or '}'" : "expecting comma or ']'");
+			}
+
+			index++;
+			if (isObject && (message = validateName(input, index))) {
+				return fail(message);
+			}
+			break;
+		}
+	}
+}
+
+} // namespace ruc::json
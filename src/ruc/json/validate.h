@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+// The JavaScript Object Notation (JSON) Data Interchange Format
+// https://www.rfc-editor.org/rfc/pdfrfc/rfc8259.txt.pdf
+
+#include <cstddef> // size_t
+#include <string_view>
+
+namespace ruc::json {
+
+struct SyntaxError {
+	size_t offset { 0 };             // Byte offset into the input
+	const char* message { nullptr }; // Static string
+};
+
+// Check that the input is a single well-formed JSON text in valid UTF-8,
+// without building tokens or values. Runs of plain string characters are
+// scanned a word at a time. Nesting up to 4096 levels deep does not allocate.
+//
+// Duplicate member names are not detected, RFC 8259 only recommends unique names.
+bool validate(std::string_view input, SyntaxError* error = nullptr);
+
+} // namespace ruc::json
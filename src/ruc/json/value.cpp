@@ -4,19 +4,28 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <algorithm> // all_of
-#include <cstdint>   // uint32_t
-#include <fstream>   // >>
-#include <iostream>  // istream, ostream
+#include <algorithm>  // all_of
+#include <charconv>   // from_chars
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstdlib>    // strtod
+#include <cstring>    // memcpy
+#include <fstream>    // >>
+#include <functional> // hash, less
+#include <iostream>   // istream, ostream
+#include <map>
+#include <memory>     // make_unique
 #include <string>
-#include <utility> // move, swap
+#include <string_view>
+#include <system_error> // errc
+#include <utility>      // as_const, move, swap
+#include <vector>
 
-#include "ruc/format/builder.h"
 #include "ruc/meta/assert.h"
 #include "ruc/json/array.h"
 #include "ruc/json/job.h"
 #include "ruc/json/object.h"
 #include "ruc/json/serializer.h"
+#include "ruc/json/stats.h"
 #include "ruc/json/value.h"
 
 namespace ruc::json {
@@ -83,16 +92,19 @@ Value::Value(const Value& other)
 		m_value.boolean = other.m_value.boolean;
 		break;
 	case Type::Number:
+		if (other.m_raw) {
+			m_raw = true;
+			m_value.string = new std::string(*other.m_value.string);
+			break;
+		}
 		m_value.number = other.m_value.number;
 		break;
 	case Type::String:
 		m_value.string = new std::string(*other.m_value.string);
 		break;
 	case Type::Array:
-		m_value.array = new Array(*other.m_value.array);
-		break;
 	case Type::Object:
-		m_value.object = new Object(*other.m_value.object);
+		copyContainer(other);
 		break;
 	case Type::Null:
 	default:
@@ -125,6 +137,7 @@ Value& Value::operator=(Value other)
 void swap(Value& left, Value& right) noexcept
 {
 	std::swap(left.m_type, right.m_type);
+	std::swap(left.m_raw, right.m_raw);
 	std::swap(left.m_value, right.m_value);
 }
 
@@ -137,6 +150,7 @@ void Value::clear()
 		m_value.boolean = false;
 		break;
 	case Type::Number:
+		destroy();
 		m_value.number = 0.0;
 		break;
 	case Type::String:
@@ -154,9 +168,29 @@ void Value::clear()
 	}
 }
 
-Value Value::parse(std::string_view input)
+Value Value::parse(std::string_view input, size_t maxDepth)
+{
+	Job job(input);
+	job.setMaxDepth(maxDepth);
+	return job.fire();
+}
+
+bool Value::parseInto(Value& target, std::string_view input, size_t maxDepth)
 {
-	return Job(input).fire();
+	thread_local Job job;
+	job.reset(input);
+	job.setMaxDepth(maxDepth);
+	return job.fireInto(target);
+}
+
+Value Value::parse(std::string_view input, ParseStats& stats, size_t maxDepth)
+{
+	Job job(input);
+	job.setMaxDepth(maxDepth);
+	job.setCollectStats(true);
+	Value value = job.fire();
+	stats = job.stats();
+	return value;
 }
 
 Value Value::parse(std::ifstream& file)
@@ -166,9 +200,24 @@ Value Value::parse(std::ifstream& file)
 	return value;
 }
 
-std::string Value::dump(const uint32_t indent, const char indentCharacter) const
+Value Value::parseRawNumbers(std::string_view input, size_t maxDepth)
+{
+	Job job(input);
+	job.setMaxDepth(maxDepth);
+	job.setRawNumbers(true);
+	return job.fire();
+}
+
+std::string Value::dump(const uint32_t indent, const char indentCharacter, const uint32_t threads) const
+{
+	Serializer serializer(indent, indentCharacter, threads);
+	return serializer.dump(*this);
+}
+
+std::string Value::dumpCached(const uint32_t indent, const char indentCharacter) const
 {
 	Serializer serializer(indent, indentCharacter);
+	serializer.setCache(true);
 	return serializer.dump(*this);
 }
 
@@ -201,10 +250,16 @@ bool Value::exists(size_t index) const
 	return index < size();
 }
 
-bool Value::exists(const std::string& key) const
+bool Value::exists(std::string_view key) const
 {
 	VERIFY(m_type == Type::Object);
-	return m_value.object->members().find(key) != m_value.object->members().end();
+	return m_value.object->find(key) != nullptr;
+}
+
+bool Value::exists(const Key& key) const
+{
+	VERIFY(m_type == Type::Object);
+	return m_value.object->find(key) != nullptr;
 }
 
 // ------------------------------------------
@@ -221,7 +276,19 @@ Value& Value::operator[](size_t index)
 	return (*m_value.array)[index];
 }
 
-Value& Value::operator[](const std::string& key)
+Value& Value::operator[](std::string_view key)
+{
+	// Implicitly convert null to an object
+	if (m_type == Type::Null) {
+		m_type = Type::Object;
+		m_value.object = new Object;
+	}
+
+	VERIFY(m_type == Type::Object);
+	return (*m_value.object)[key];
+}
+
+Value& Value::operator[](const Key& key)
 {
 	// Implicitly convert null to an object
 	if (m_type == Type::Null) {
@@ -236,13 +303,19 @@ Value& Value::operator[](const std::string& key)
 const Value& Value::operator[](size_t index) const
 {
 	VERIFY(m_type == Type::Array);
-	return (*m_value.array)[index];
+	return std::as_const(*m_value.array).at(index);
 }
 
-const Value& Value::operator[](const std::string& key) const
+const Value& Value::operator[](std::string_view key) const
 {
 	VERIFY(m_type == Type::Object);
-	return (*m_value.object)[key];
+	return std::as_const(*m_value.object).at(key);
+}
+
+const Value& Value::operator[](const Key& key) const
+{
+	VERIFY(m_type == Type::Object);
+	return std::as_const(*m_value.object).at(key);
 }
 
 Value& Value::at(size_t index)
@@ -251,7 +324,13 @@ Value& Value::at(size_t index)
 	return m_value.array->at(index);
 }
 
-Value& Value::at(const std::string& key)
+Value& Value::at(std::string_view key)
+{
+	VERIFY(m_type == Type::Object);
+	return m_value.object->at(key);
+}
+
+Value& Value::at(const Key& key)
 {
 	VERIFY(m_type == Type::Object);
 	return m_value.object->at(key);
@@ -260,13 +339,19 @@ Value& Value::at(const std::string& key)
 const Value& Value::at(size_t index) const
 {
 	VERIFY(m_type == Type::Array);
-	return m_value.array->at(index);
+	return std::as_const(*m_value.array).at(index);
 }
 
-const Value& Value::at(const std::string& key) const
+const Value& Value::at(std::string_view key) const
 {
 	VERIFY(m_type == Type::Object);
-	return m_value.object->at(key);
+	return std::as_const(*m_value.object).at(key);
+}
+
+const Value& Value::at(const Key& key) const
+{
+	VERIFY(m_type == Type::Object);
+	return std::as_const(*m_value.object).at(key);
 }
 
 // ------------------------------------------
@@ -288,28 +373,516 @@ size_t Value::size() const
 	}
 }
 
+size_t Value::memoryUsage() const
+{
+	return measure(*this).memoryUsage;
+}
+
 // ------------------------------------------
 
+void Value::copyContainer(const Value& other)
+{
+	// Nested containers are copied top-down with an explicit stack instead of
+	// recursion, so deeply nested trees can not overflow the call stack
+
+	struct Frame {
+		const Value* source;
+		Value* destination;
+		size_t index { 0 };
+		std::map<std::string, Value, std::less<>>::const_iterator member {};
+	};
+
+	// Copy scalars and allocate containers, returns if a container was allocated
+	auto copyShallow = [](const Value& source, Value& destination) -> bool {
+		destination.m_type = source.m_type;
+		switch (source.m_type) {
+		case Type::Number:
+			if (source.m_raw) {
+				destination.m_raw = true;
+				destination.m_value.string = new std::string(*source.m_value.string);
+				return false;
+			}
+			destination.m_value = source.m_value;
+			return false;
+		case Type::String:
+			destination.m_value.string = new std::string(*source.m_value.string);
+			return false;
+		case Type::Array:
+			// Packed arrays hold no containers, they are copied as a whole
+			if (source.m_value.array->isPacked()) {
+				destination.m_value.array = new Array(*source.m_value.array);
+				return false;
+			}
+			destination.m_value.array = new Array;
+			destination.m_value.array->m_elements.resize(source.m_value.array->size());
+			destination.m_value.array->setCachedHash(source.m_value.array->cachedHash());
+			return true;
+		case Type::Object:
+			destination.m_value.object = new Object;
+			destination.m_value.object->setCachedHash(source.m_value.object->cachedHash());
+			if (source.m_value.object->isShaped()) {
+				destination.m_value.object->m_slots = std::make_unique<Object::Slots>();
+				destination.m_value.object->m_slots->shape = source.m_value.object->m_slots->shape;
+				destination.m_value.object->m_slots->values.resize(source.m_value.object->size());
+			}
+			return true;
+		case Type::Null:
+		case Type::Bool:
+		default:
+			destination.m_value = source.m_value;
+			return false;
+		}
+	};
+
+	auto frame = [](const Value& source, Value& destination) -> Frame {
+		if (source.m_type == Type::Object) {
+			return { &source, &destination, 0, source.m_value.object->m_members.cbegin() };
+		}
+		return { &source, &destination };
+	};
+
+	copyShallow(other, *this);
+
+	std::vector<Frame> stack;
+	Frame current = frame(other, *this);
+	for (;;) {
+		const Value* source = nullptr;
+		Value* destination = nullptr;
+
+		if (current.source->m_type == Type::Array) {
+			if (current.index < current.source->m_value.array->size()) {
+				source = &current.source->m_value.array->m_elements[current.index];
+				destination = &current.destination->m_value.array->m_elements[current.index];
+				current.index++;
+			}
+		}
+		else if (current.source->m_value.object->isShaped()) {
+			if (current.index < current.source->m_value.object->size()) {
+				source = &current.source->m_value.object->m_slots->values[current.index];
+				destination = &current.destination->m_value.object->m_slots->values[current.index];
+				current.index++;
+			}
+		}
+		else if (current.member != current.source->m_value.object->m_members.cend()) {
+			auto& members = current.destination->m_value.object->m_members;
+			source = &current.member->second;
+			destination = &members.emplace_hint(members.end(), current.member->first, nullptr)->second;
+			current.member++;
+		}
+
+		// Descend into the copied container
+		if (source != nullptr) {
+			if (copyShallow(*source, *destination)) {
+				stack.push_back(current);
+				current = frame(*source, *destination);
+			}
+			continue;
+		}
+
+		// All members have been copied, continue with the parent
+		if (stack.empty()) {
+			break;
+		}
+		current = stack.back();
+		stack.pop_back();
+	}
+}
+
 void Value::destroy()
 {
 	switch (m_type) {
+	case Type::Number:
+		if (m_raw) {
+			delete m_value.string;
+			m_raw = false;
+		}
+		break;
 	case Type::String:
 		delete m_value.string;
 		break;
 	case Type::Array:
-		delete m_value.array;
-		break;
 	case Type::Object:
-		delete m_value.object;
+		destroyContainer();
 		break;
 	case Type::Null:
 	case Type::Bool:
-	case Type::Number:
 	default:
 		break;
 	}
 }
 
+void Value::destroyContainer()
+{
+	// Nested containers are freed bottom-up with an explicit stack instead of
+	// recursion, so deeply nested trees can not overflow the call stack
+
+	struct Frame {
+		Value* value;
+		size_t index { 0 };
+		std::map<std::string, Value, std::less<>>::iterator member {};
+	};
+
+	auto frame = [](Value& value) -> Frame {
+		if (value.m_type == Type::Object) {
+			return { &value, 0, value.m_value.object->m_members.begin() };
+		}
+		return { &value };
+	};
+
+	auto isContainer = [](const Value& value) {
+		return value.m_type == Type::Array || value.m_type == Type::Object;
+	};
+
+	std::vector<Frame> stack;
+	Frame current = frame(*this);
+	for (;;) {
+		// Find the next nested container
+		Value* child = nullptr;
+		if (current.value->m_type == Type::Array || current.value->m_value.object->isShaped()) {
+			auto& elements = current.value->m_type == Type::Array
+			                     ? current.value->m_value.array->m_elements
+			                     : current.value->m_value.object->m_slots->values;
+			while (child == nullptr && current.index < elements.size()) {
+				Value& element = elements[current.index++];
+				child = isContainer(element) ? &element : nullptr;
+			}
+		}
+		else {
+			auto& members = current.value->m_value.object->m_members;
+			while (child == nullptr && current.member != members.end()) {
+				Value& member = (current.member++)->second;
+				child = isContainer(member) ? &member : nullptr;
+			}
+		}
+
+		if (child != nullptr) {
+			stack.push_back(current);
+			current = frame(*child);
+			continue;
+		}
+
+		// No nested containers are left, so deleting this one does not recurse
+		if (current.value->m_type == Type::Array) {
+			delete current.value->m_value.array;
+		}
+		else {
+			delete current.value->m_value.object;
+		}
+		current.value->m_type = Type::Null;
+
+		if (stack.empty()) {
+			break;
+		}
+		current = stack.back();
+		stack.pop_back();
+	}
+}
+
+double Value::rawToDouble() const
+{
+	// The text was validated by the parser, from_chars does not depend on the locale
+	const std::string& text = *m_value.string;
+	double number = 0.0;
+	if (std::from_chars(text.data(), text.data() + text.size(), number).ec == std::errc::result_out_of_range) {
+		// Saturate to infinity or zero
+		return std::strtod(text.c_str(), nullptr);
+	}
+	return number;
+}
+
+// ------------------------------------------
+
+// SplitMix64 finalizer
+static size_t mix(uint64_t value)
+{
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111eb;
+	value ^= value >> 31;
+	return static_cast<size_t>(value);
+}
+
+static size_t hashNumber(double number)
+{
+	// Normalize -0.0 so it hashes the same as 0.0, as they compare equal
+	number = number == 0.0 ? 0.0 : number;
+	uint64_t bits;
+	std::memcpy(&bits, &number, sizeof(bits));
+	return mix((static_cast<uint64_t>(Value::Type::Number) + 1) ^ mix(bits));
+}
+
+// Hash of a value that is not hashed through its elements, 0 for containers
+// without a memoized hash
+static size_t hashShallow(const Value& value)
+{
+	// Seed every type differently, so that for example null != false != 0
+	uint64_t seed = static_cast<uint64_t>(value.type()) + 1;
+
+	switch (value.type()) {
+	case Value::Type::Null:
+		return mix(seed);
+	case Value::Type::Bool:
+		return mix(seed ^ (value.asBool() ? 0x100 : 0x200));
+	case Value::Type::Number:
+		return hashNumber(value.asDouble());
+	case Value::Type::String:
+		return mix(seed ^ std::hash<std::string> {}(value.asString()));
+	case Value::Type::Array:
+		return value.asArray().cachedHash();
+	case Value::Type::Object:
+		return value.asObject().cachedHash();
+	default:
+		VERIFY_NOT_REACHED();
+		return 0;
+	}
+}
+
+size_t hash(const Value& value, bool memoize)
+{
+	// Containers are hashed after their elements, with an explicit stack
+	// instead of recursion, so deeply nested trees can not overflow the call
+	// stack
+
+	struct Frame {
+		const Value* container;
+		uint64_t result { 0 };
+		size_t index { 0 };
+		Members::Iterator member {};
+		Members::Iterator end {};
+		const std::string* name { nullptr }; // Of the member being hashed
+	};
+
+	// Combine the members of objects with a commutative sum to be independent
+	// of their order
+	auto combine = [](Frame& frame, size_t result) {
+		if (frame.container->type() == Value::Type::Array) {
+			frame.result = mix(frame.result * 31 + result);
+		}
+		else {
+			frame.result += mix(std::hash<std::string> {}(*frame.name) ^ mix(result));
+		}
+	};
+
+	auto finish = [memoize](const Frame& frame) -> size_t {
+		uint64_t seed = static_cast<uint64_t>(frame.container->type()) + 1;
+		size_t size = frame.container->size();
+		uint64_t result = frame.container->type() == Value::Type::Array
+		                      ? mix(frame.result ^ size)
+		                      : mix(seed ^ frame.result ^ mix(size));
+		result += (result == 0);
+
+		if (memoize && frame.container->type() == Value::Type::Array) {
+			frame.container->asArray().setCachedHash(result);
+		}
+		else if (memoize) {
+			frame.container->asObject().setCachedHash(result);
+		}
+		return result;
+	};
+
+	std::vector<Frame> stack;
+	const Value* current = &value;
+	for (;;) {
+		size_t result = hashShallow(*current);
+		bool isContainer = current->type() == Value::Type::Array || current->type() == Value::Type::Object;
+		if (isContainer && result == 0) {
+			Frame frame { current };
+			if (current->type() == Value::Type::Array) {
+				frame.result = static_cast<uint64_t>(Value::Type::Array) + 1;
+
+				// Packed numbers are hashed without converting the array
+				const Array& array = current->asArray();
+				if (array.packing() != Array::Packing::None) {
+					for (; frame.index < array.size(); ++frame.index) {
+						combine(frame, hashNumber(array.number(frame.index)));
+					}
+				}
+			}
+			else {
+				frame.member = current->asObject().members().begin();
+				frame.end = current->asObject().members().end();
+			}
+			stack.push_back(frame);
+		}
+		else if (stack.empty()) {
+			return result;
+		}
+		else {
+			combine(stack.back(), result);
+		}
+
+		// Find the next value, finishing all the containers that are done
+		current = nullptr;
+		while (current == nullptr) {
+			Frame& frame = stack.back();
+			if (frame.container->type() == Value::Type::Array) {
+				if (frame.index < frame.container->size()) {
+					current = &frame.container->asArray().elements()[frame.index++];
+					break;
+				}
+			}
+			else if (frame.member != frame.end) {
+				frame.name = &frame.member.name();
+				current = &frame.member.value();
+				++frame.member;
+				break;
+			}
+
+			result = finish(frame);
+			stack.pop_back();
+			if (stack.empty()) {
+				return result;
+			}
+			combine(stack.back(), result);
+		}
+	}
+}
+
+// A memoized hash can miss writes through a reference that was handed out,
+// every container above such a reference has lent, see Serializer::keepOutput
+template<typename Container>
+static bool reliableHash(const Container& container)
+{
+	return container.cachedHash() != 0 && !container.lent();
+}
+
+enum class Comparison : uint8_t {
+	Unequal,
+	Equal,
+	Elements, // Equal so far, the elements still have to be compared
+};
+
+static Comparison compareShallow(const Value& left, const Value& right)
+{
+	if (&left == &right) {
+		return Comparison::Equal;
+	}
+
+	if (left.type() != right.type() || left.size() != right.size()) {
+		return Comparison::Unequal;
+	}
+
+	auto compare = [](bool equal) { return equal ? Comparison::Equal : Comparison::Unequal; };
+
+	switch (left.type()) {
+	case Value::Type::Null:
+		return Comparison::Equal;
+	case Value::Type::Bool:
+		return compare(left.asBool() == right.asBool());
+	case Value::Type::Number:
+		return compare(left.asDouble() == right.asDouble());
+	case Value::Type::String:
+		return compare(left.asString() == right.asString());
+	case Value::Type::Array: {
+		const Array& leftArray = left.asArray();
+		const Array& rightArray = right.asArray();
+		if (reliableHash(leftArray) && reliableHash(rightArray)
+		    && leftArray.cachedHash() != rightArray.cachedHash()) {
+			return Comparison::Unequal;
+		}
+
+		// Packed numbers are compared without converting the array
+		bool leftPacked = leftArray.packing() != Array::Packing::None;
+		bool rightPacked = rightArray.packing() != Array::Packing::None;
+		if (!leftPacked && !rightPacked) {
+			return left.size() > 0 ? Comparison::Elements : Comparison::Equal;
+		}
+
+		for (size_t i = 0; i < leftArray.size(); ++i) {
+			const Value* leftElement = leftPacked ? nullptr : &leftArray.elements()[i];
+			const Value* rightElement = rightPacked ? nullptr : &rightArray.elements()[i];
+			if ((leftElement != nullptr && leftElement->type() != Value::Type::Number)
+			    || (rightElement != nullptr && rightElement->type() != Value::Type::Number)) {
+				return Comparison::Unequal;
+			}
+
+			double leftNumber = leftPacked ? leftArray.number(i) : leftElement->asDouble();
+			double rightNumber = rightPacked ? rightArray.number(i) : rightElement->asDouble();
+			if (leftNumber != rightNumber) {
+				return Comparison::Unequal;
+			}
+		}
+		return Comparison::Equal;
+	}
+	case Value::Type::Object: {
+		const Object& leftObject = left.asObject();
+		const Object& rightObject = right.asObject();
+		if (reliableHash(leftObject) && reliableHash(rightObject)
+		    && leftObject.cachedHash() != rightObject.cachedHash()) {
+			return Comparison::Unequal;
+		}
+		return left.size() > 0 ? Comparison::Elements : Comparison::Equal;
+	}
+	default:
+		VERIFY_NOT_REACHED();
+		return Comparison::Unequal;
+	}
+}
+
+bool operator==(const Value& left, const Value& right)
+{
+	// Containers are compared element by element with an explicit stack
+	// instead of recursion, so deeply nested trees can not overflow the call
+	// stack
+
+	struct Frame {
+		const Value* left;
+		const Value* right;
+		size_t index { 0 };
+		Members::Iterator leftMember {};
+		Members::Iterator rightMember {};
+	};
+
+	std::vector<Frame> stack;
+	const Value* currentLeft = &left;
+	const Value* currentRight = &right;
+	for (;;) {
+		Comparison comparison = compareShallow(*currentLeft, *currentRight);
+		if (comparison == Comparison::Unequal) {
+			return false;
+		}
+		if (comparison == Comparison::Elements) {
+			Frame frame { currentLeft, currentRight };
+			if (currentLeft->type() == Value::Type::Object) {
+				frame.leftMember = currentLeft->asObject().members().begin();
+				frame.rightMember = currentRight->asObject().members().begin();
+			}
+			stack.push_back(frame);
+		}
+
+		// Find the next pair of values, members are sorted by name so they can
+		// be compared pairwise
+		currentLeft = nullptr;
+		while (currentLeft == nullptr) {
+			if (stack.empty()) {
+				return true;
+			}
+
+			Frame& frame = stack.back();
+			if (frame.index == frame.left->size()) {
+				stack.pop_back();
+				continue;
+			}
+
+			if (frame.left->type() == Value::Type::Array) {
+				currentLeft = &frame.left->asArray().elements()[frame.index];
+				currentRight = &frame.right->asArray().elements()[frame.index];
+			}
+			else {
+				if (frame.leftMember.name() != frame.rightMember.name()) {
+					return false;
+				}
+				currentLeft = &frame.leftMember.value();
+				currentRight = &frame.rightMember.value();
+				++frame.leftMember;
+				++frame.rightMember;
+			}
+			frame.index++;
+		}
+	}
+}
+
 // ------------------------------------------
 
 std::istream& operator>>(std::istream& input, Value& value)
@@ -332,9 +905,4 @@ std::ostream& operator<<(std::ostream& output, const Value& value)
 	return output << value.dump(4);
 }
 
-void format(ruc::format::Builder& builder, const Value& value)
-{
-	builder.putString(value.dump(4));
-}
-
 } // namespace ruc::json
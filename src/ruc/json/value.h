@@ -6,21 +6,24 @@
 
 #pragma once
 
-#include <cstddef> // nullptr_t, size_t
-#include <cstdint> // uint8_t, uint32_t
+#include <cstddef>    // nullptr_t, size_t
+#include <cstdint>    // uint8_t, uint32_t
+#include <functional> // hash
 #include <initializer_list>
 #include <iostream> // istream, ostream
 #include <string>
+#include <string_view>
 #include <utility> // forward
 
-#include "ruc/format/builder.h"
 #include "ruc/json/fromjson.h"
+#include "ruc/json/key.h"
 #include "ruc/json/tojson.h"
 
 namespace ruc::json {
 
 class Array;
 class Object;
+struct ParseStats;
 
 class Value {
 private:
@@ -65,9 +68,23 @@ public:
 
 	// --------------------------------------
 
-	static Value parse(std::string_view input);
+	// Nesting deeper than maxDepth is rejected, 0 is unlimited
+	static Value parse(std::string_view input, size_t maxDepth = 0);
 	static Value parse(std::ifstream& file);
-	std::string dump(const uint32_t indent = 0, const char indentCharacter = ' ') const;
+	// Parse into target, recycling the strings, array storage and object nodes
+	// it already holds. Scratch buffers are kept per thread. On failure target
+	// is null and false is returned
+	static bool parseInto(Value& target, std::string_view input, size_t maxDepth = 0);
+	// Parse and fill in stats, which times the lexer and parser and walks the result
+	static Value parse(std::string_view input, ParseStats& stats, size_t maxDepth = 0);
+	// Keep the validated text of numbers, which is converted when it is read
+	// and written back as-is by dump, so numbers pass through losslessly
+	static Value parseRawNumbers(std::string_view input, size_t maxDepth = 0);
+	std::string dump(const uint32_t indent = 0, const char indentCharacter = ' ', const uint32_t threads = 1) const;
+	// Reuse the output of containers that were not modified since the last
+	// cached dump, see Serializer::setCache. Output is kept in the containers
+	// without synchronization, other threads may not read this value meanwhile
+	std::string dumpCached(const uint32_t indent = 0, const char indentCharacter = ' ') const;
 
 	void clear();
 
@@ -75,20 +92,27 @@ public:
 	void emplace(const std::string& key, Value value);
 
 	bool exists(size_t index) const;
-	bool exists(const std::string& key) const;
+	bool exists(std::string_view key) const;
+	bool exists(const Key& key) const;
 
 	// --------------------------------------
 
 	// Array index operator
 	Value& operator[](size_t index);
-	Value& operator[](const std::string& key);
+	Value& operator[](std::string_view key);
+	Value& operator[](const Key& key);
+	// Unlike the mutable operators, which add a missing element or member,
+	// const access has no side effects and throws std::out_of_range like at()
 	const Value& operator[](size_t index) const;
-	const Value& operator[](const std::string& key) const;
+	const Value& operator[](std::string_view key) const;
+	const Value& operator[](const Key& key) const;
 
 	Value& at(size_t index);
-	Value& at(const std::string& key);
+	Value& at(std::string_view key);
+	Value& at(const Key& key);
 	const Value& at(size_t index) const;
-	const Value& at(const std::string& key) const;
+	const Value& at(std::string_view key) const;
+	const Value& at(const Key& key) const;
 
 	// --------------------------------------
 
@@ -110,17 +134,27 @@ public:
 
 	Type type() const { return m_type; }
 	size_t size() const;
+	// Heap bytes held by the strings, arrays and object nodes, allocator
+	// overhead excluded. The value itself is not counted
+	size_t memoryUsage() const;
 
 	bool asBool() const { return m_value.boolean; }
-	double asDouble() const { return m_value.number; }
+	double asDouble() const { return m_raw ? rawToDouble() : m_value.number; }
 	const std::string& asString() const { return *m_value.string; }
 	const Array& asArray() const { return *m_value.array; }
 	const Object& asObject() const { return *m_value.object; }
 
+	// Text of a number from parseRawNumbers, empty for other values
+	std::string_view rawNumber() const { return m_raw ? std::string_view(*m_value.string) : std::string_view(); }
+
 private:
+	void copyContainer(const Value& other);
 	void destroy();
+	void destroyContainer();
+	double rawToDouble() const;
 
 	Type m_type { Type::Null };
+	bool m_raw { false }; // Number stored as its text, in string
 
 	union {
 		bool boolean;
@@ -131,19 +165,103 @@ private:
 	} m_value {};
 };
 
+// Structural hash, independent of the order in which object members were added.
+// When memoize is set, container hashes are stored in the nodes and reused
+// until the container is accessed mutably again. Note that modifying a nested
+// value through a retained reference does not reset the hashes of its parents.
+size_t hash(const Value& value, bool memoize = false);
+
+// Deep equality, short-circuits on type, size and mismatches of memoized hashes
+// of containers that have not lent a reference
+bool operator==(const Value& left, const Value& right);
+
 std::istream& operator>>(std::istream& input, Value& value);
 std::ostream& operator<<(std::ostream& output, const Value& value);
 
-void format(ruc::format::Builder& builder, const Value& value);
+// -----------------------------------------
 
-} // namespace ruc::json
+// Members are defined here, as iterating them needs a complete Value
 
-/**
- * User-defined string literal
- *
- * Example usage: auto json = "[ 3.14, true, null ]"_json;
- */
-inline ruc::json::Value operator"" _json(const char* input, size_t length)
+inline Members::Iterator& Members::Iterator::operator++()
+{
+	if (m_name != nullptr) {
+		m_name++;
+		m_value++;
+	}
+	else {
+		m_member++;
+	}
+
+	return *this;
+}
+
+inline Members::Iterator Members::Iterator::operator++(int)
+{
+	Iterator result = *this;
+	++*this;
+	return result;
+}
+
+inline bool Members::Iterator::operator==(const Iterator& other) const
+{
+	return m_name != nullptr || other.m_name != nullptr ? m_name == other.m_name : m_member == other.m_member;
+}
+
+inline const std::string& Members::Iterator::name() const
+{
+	return m_name != nullptr ? *m_name : m_member->first;
+}
+
+inline const Value& Members::Iterator::value() const
+{
+	return m_value != nullptr ? *m_value : m_member->second;
+}
+
+inline Members::Iterator Members::begin() const
+{
+	if (m_object.isShaped()) {
+		const auto& slots = *m_object.m_slots;
+		return Iterator(slots.shape->names().data(), slots.values.data());
+	}
+
+	return Iterator(m_object.m_members.cbegin());
+}
+
+inline Members::Iterator Members::end() const
+{
+	if (m_object.isShaped()) {
+		const auto& slots = *m_object.m_slots;
+		size_t size = slots.shape->size();
+		return Iterator(slots.shape->names().data() + size, slots.values.data() + size);
+	}
+
+	return Iterator(m_object.m_members.cend());
+}
+
+inline size_t Members::size() const
 {
-	return ruc::json::Value::parse(std::string(input, length));
+	return m_object.size();
 }
+
+} // namespace ruc::json
+
+template<>
+struct std::hash<ruc::json::Value> {
+	size_t operator()(const ruc::json::Value& value) const
+	{
+		return ruc::json::hash(value);
+	}
+};
+
+namespace ruc::format {
+
+template<typename T>
+struct Formatter;
+
+} // namespace ruc::format
+
+// Declared here so that every translation unit sees the specialization before
+// formatting a value, it is defined in ruc/json/formatter.h. Formatting without
+// that header fails to build instead of using the empty primary template.
+template<>
+struct ruc::format::Formatter<ruc::json::Value>;
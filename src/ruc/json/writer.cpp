@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <charconv> // to_chars
+#include <cstddef>  // nullptr_t, size_t
+#include <cstdint>  // int64_t, uint32_t, uint64_t
+#include <string>
+#include <string_view>
+
+#include "ruc/json/serializer.h"
+#include "ruc/json/value.h"
+#include "ruc/json/writer.h"
+#include "ruc/meta/assert.h"
+
+namespace ruc::json {
+
+Writer::Writer(const uint32_t indent, const char indentCharacter)
+	: m_serializer(indent, indentCharacter)
+{
+}
+
+Writer::Writer(const Sink& sink, const uint32_t indent, const char indentCharacter)
+	: m_serializer(indent, indentCharacter)
+	, m_sink(sink)
+{
+	m_serializer.m_sink = &m_sink;
+}
+
+Writer::~Writer()
+{
+}
+
+// -----------------------------------------
+
+Writer& Writer::beginObject()
+{
+	beginContainer(true);
+	return *this;
+}
+
+Writer& Writer::endObject()
+{
+	endContainer(true);
+	return *this;
+}
+
+Writer& Writer::beginArray()
+{
+	beginContainer(false);
+	return *this;
+}
+
+Writer& Writer::endArray()
+{
+	endContainer(false);
+	return *this;
+}
+
+Writer& Writer::key(std::string_view name)
+{
+	VERIFY(!m_stack.empty() && m_stack.back().isObject, "key outside of an object");
+	VERIFY(m_stack.back().expectName, "key '{}' follows a key without a value", name);
+
+	Frame& frame = m_stack.back();
+	std::string& output = m_serializer.m_output;
+	if (frame.count > 0) {
+		output += m_serializer.m_indent ? ",\n" : ",";
+	}
+	m_serializer.dumpIndentation(m_stack.size());
+
+	output += '"';
+	for (char character : name) {
+		Serializer::appendEscaped(output, character);
+	}
+	output += m_serializer.m_indent ? "\": " : "\":";
+	frame.expectName = false;
+
+	return *this;
+}
+
+Writer& Writer::value(std::nullptr_t)
+{
+	beginValue();
+	m_serializer.m_output += "null";
+	endValue();
+	return *this;
+}
+
+Writer& Writer::value(bool boolean)
+{
+	beginValue();
+	m_serializer.m_output += boolean ? "true" : "false";
+	endValue();
+	return *this;
+}
+
+Writer& Writer::value(std::string_view string)
+{
+	beginValue();
+	std::string& output = m_serializer.m_output;
+	output += '"';
+	for (char character : string) {
+		Serializer::appendEscaped(output, character);
+	}
+	output += '"';
+	endValue();
+	return *this;
+}
+
+Writer& Writer::value(const Value& value)
+{
+	beginValue();
+	m_serializer.dumpHelper(value, m_stack.size());
+	endValue();
+	return *this;
+}
+
+void Writer::flush()
+{
+	flush(0);
+}
+
+void Writer::clear()
+{
+	m_serializer.m_output.clear();
+	m_complete = false;
+	m_stack.clear();
+}
+
+// -----------------------------------------
+
+void Writer::beginValue()
+{
+	if (m_stack.empty()) {
+		VERIFY(!m_complete, "writer already holds a complete value");
+		return;
+	}
+
+	Frame& frame = m_stack.back();
+	if (frame.isObject) {
+		// The separator and indentation were written before the name
+		VERIFY(!frame.expectName, "object member without a key");
+		frame.expectName = true;
+	}
+	else {
+		if (frame.count > 0) {
+			m_serializer.m_output += m_serializer.m_indent ? ",\n" : ",";
+		}
+		m_serializer.dumpIndentation(m_stack.size());
+	}
+	frame.count++;
+}
+
+void Writer::endValue()
+{
+	if (m_stack.empty()) {
+		m_complete = true;
+	}
+
+	flush(Serializer::s_chunkSize);
+}
+
+void Writer::beginContainer(bool isObject)
+{
+	beginValue();
+	m_serializer.m_output += isObject ? '{' : '[';
+	if (!m_serializer.m_compact) {
+		m_serializer.m_output += '\n';
+	}
+	m_stack.push_back({ isObject, isObject, 0 });
+}
+
+void Writer::endContainer(bool isObject)
+{
+	VERIFY(!m_stack.empty() && m_stack.back().isObject == isObject, "no open {} to end", isObject ? "object" : "array");
+	VERIFY(!isObject || m_stack.back().expectName, "object member has a key without a value");
+
+	if (m_stack.back().count > 0 && m_serializer.m_indent) {
+		m_serializer.m_output += '\n';
+		m_serializer.dumpIndentation(m_stack.size() - 1);
+	}
+	m_serializer.m_output += isObject ? '}' : ']';
+	m_stack.pop_back();
+	endValue();
+}
+
+void Writer::appendInteger(int64_t number)
+{
+	// Integers are written exactly, unlike numbers stored in values
+	char buffer[24];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+	m_serializer.m_output.append(buffer, result.ptr);
+}
+
+void Writer::appendInteger(uint64_t number)
+{
+	char buffer[24];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+	m_serializer.m_output.append(buffer, result.ptr);
+}
+
+void Writer::flush(size_t threshold)
+{
+	std::string& output = m_serializer.m_output;
+	if (m_sink && !output.empty() && output.size() >= threshold) {
+		m_sink(output);
+		output.clear();
+	}
+}
+
+} // namespace ruc::json
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>     // nullptr_t, size_t
+#include <cstdint>     // int64_t, uint32_t, uint64_t
+#include <functional>  // function
+#include <string>
+#include <string_view>
+#include <type_traits> // is_arithmetic_v, is_floating_point_v, is_signed_v
+#include <vector>
+
+#include "ruc/json/serializer.h"
+#include "ruc/json/value.h"
+
+namespace ruc::json {
+
+// Writes JSON as it is being produced, without building values. The layout and
+// the escaping and number formatting are the same as dump() with the same
+// indentation. Calls that would not produce valid JSON, like a member without
+// a key or closing the wrong container, fail a VERIFY.
+//
+// Output is kept in a buffer that can be cleared and reused, or handed to the
+// sink in chunks, so memory use only grows with the nesting depth.
+class Writer {
+public:
+	using Sink = std::function<void(std::string_view)>;
+
+	// Indent 0 minifies
+	Writer(const uint32_t indent = 0, const char indentCharacter = ' ');
+	Writer(const Sink& sink, const uint32_t indent = 0, const char indentCharacter = ' ');
+	virtual ~Writer();
+
+	// The serializer refers to the sink
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+
+	Writer& beginObject();
+	Writer& endObject();
+	Writer& beginArray();
+	Writer& endArray();
+	Writer& key(std::string_view name);
+
+	Writer& value(std::nullptr_t);
+	Writer& value(bool boolean);
+	Writer& value(std::string_view string);
+	Writer& value(const char* string) { return value(std::string_view(string)); }
+	Writer& value(const Value& value);
+
+	template<typename T>
+	requires std::is_arithmetic_v<T>
+	Writer& value(T number)
+	{
+		beginValue();
+		if constexpr (std::is_floating_point_v<T>) {
+			Serializer::appendNumber(m_serializer.m_output, number);
+		}
+		else if constexpr (std::is_signed_v<T>) {
+			appendInteger(static_cast<int64_t>(number));
+		}
+		else {
+			appendInteger(static_cast<uint64_t>(number));
+		}
+		endValue();
+		return *this;
+	}
+
+	// Whether a single value has been written and all containers are closed
+	bool complete() const { return m_complete; }
+
+	// Output that has not been handed to the sink
+	const std::string& output() const { return m_serializer.m_output; }
+	// Hands the remaining output to the sink
+	void flush();
+	// Start over, the buffer keeps its capacity
+	void clear();
+
+private:
+	// Container that is currently being written
+	struct Frame {
+		bool isObject { false };
+		bool expectName { false };
+		size_t count { 0 };
+	};
+
+	void beginValue();
+	void endValue();
+	void beginContainer(bool isObject);
+	void endContainer(bool isObject);
+	void appendInteger(int64_t number);
+	void appendInteger(uint64_t number);
+	void flush(size_t threshold);
+
+	Serializer m_serializer;
+	Sink m_sink;
+	bool m_complete { false };
+	std::vector<Frame> m_stack;
+};
+
+} // namespace ruc::json
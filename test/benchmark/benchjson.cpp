@@ -0,0 +1,425 @@
+/*
+ * Copyright (C) 2022 Riyyi
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm> // min
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint> // int64_t, uint32_t, uint64_t
+#include <cstdlib> // free, malloc
+#include <functional>
+#include <limits> // numeric_limits
+#include <new>    // bad_alloc
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ruc/argparser.h"
+#include "ruc/file.h"
+#include "ruc/format/print.h"
+#include "ruc/json/array.h"
+#include "ruc/json/json.h"
+#include "ruc/json/object.h"
+#include "ruc/json/tape.h"
+#include "ruc/json/transcoder.h"
+#include "ruc/json/validate.h"
+#include "ruc/timer.h"
+
+// -----------------------------------------
+// Allocation counting
+
+static std::atomic<uint64_t> s_allocations { 0 };
+
+void* operator new(size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = malloc(size != 0 ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+// -----------------------------------------
+// Corpus generation
+
+// Deterministic linear congruential generator, so every run sees the same corpus
+class Random {
+public:
+	uint32_t next()
+	{
+		m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+		return static_cast<uint32_t>(m_state >> 33);
+	}
+
+	uint32_t next(uint32_t max) { return next() % max; }
+
+private:
+	uint64_t m_state { 0x5eed };
+};
+
+static void appendWord(std::string& output, Random& random)
+{
+	static constexpr std::string_view words[] = {
+		"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+		"sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore",
+	};
+	output += words[random.next(sizeof(words) / sizeof(words[0]))];
+}
+
+static void appendNumber(std::string& output, Random& random)
+{
+	if (random.next(2) == 0) {
+		output += std::to_string(static_cast<int32_t>(random.next()) / 1000);
+		return;
+	}
+
+	output += std::to_string(random.next(100000));
+	output += '.';
+	output += std::to_string(random.next(1000000));
+}
+
+static void appendRecord(std::string& output, Random& random, size_t id)
+{
+	output += R"({"id":)" + std::to_string(id) + R"(,"name":")";
+	appendWord(output, random);
+	output += R"(","active":)";
+	output += random.next(2) ? "true" : "false";
+	output += R"(,"score":)";
+	appendNumber(output, random);
+	output += R"(,"tags":[")";
+	appendWord(output, random);
+	output += R"(",")";
+	appendWord(output, random);
+	output += R"("],"parent":null})";
+}
+
+// Array of number rows
+static std::string generateNumbers(size_t bytes, Random& random)
+{
+	std::string output = "[";
+	while (output.size() < bytes) {
+		output += '[';
+		for (size_t i = 0; i < 16; ++i) {
+			appendNumber(output, random);
+			output += i < 15 ? "," : "],";
+		}
+	}
+	output.back() = ']';
+	return output;
+}
+
+// Array of sentences
+static std::string generateStrings(size_t bytes, Random& random)
+{
+	std::string output = "[";
+	while (output.size() < bytes) {
+		output += '"';
+		for (size_t i = random.next(32) + 1; i > 0; --i) {
+			appendWord(output, random);
+			output += i > 1 ? " " : "\",";
+		}
+	}
+	output.back() = ']';
+	return output;
+}
+
+// Array of alternating array/object chains
+static std::string generateNested(size_t bytes, Random& random)
+{
+	constexpr size_t depth = 64;
+
+	std::string output = "[";
+	while (output.size() < bytes) {
+		for (size_t i = 0; i < depth; ++i) {
+			output += i % 2 ? R"({"child":)" : "[";
+		}
+		appendNumber(output, random);
+		for (size_t i = depth; i > 0; --i) {
+			output += (i - 1) % 2 ? "}" : "]";
+		}
+		output += ',';
+	}
+	output.back() = ']';
+	return output;
+}
+
+// Array of objects with many members
+static std::string generateWide(size_t bytes, Random& random)
+{
+	std::string output = "[";
+	while (output.size() < bytes) {
+		output += '{';
+		for (size_t i = 0; i < 512; ++i) {
+			output += "\"member" + std::to_string(i) + "\":";
+			appendNumber(output, random);
+			output += i < 511 ? "," : "},";
+		}
+	}
+	output.back() = ']';
+	return output;
+}
+
+// Newline delimited records
+static std::string generateNdjson(size_t bytes, Random& random)
+{
+	std::string output;
+	for (size_t id = 0; output.size() < bytes; ++id) {
+		appendRecord(output, random, id);
+		output += '\n';
+	}
+	return output;
+}
+
+// -----------------------------------------
+// Measurements
+
+struct Measurement {
+	double seconds { std::numeric_limits<double>::max() };
+	uint64_t allocations { 0 };
+};
+
+// Best time of all iterations, allocations of the last iteration
+static Measurement measure(size_t iterations, const std::function<void()>& function)
+{
+	Measurement result;
+	for (size_t i = 0; i < iterations; ++i) {
+		uint64_t allocations = s_allocations.load(std::memory_order_relaxed);
+		ruc::Timer timer;
+		function();
+		double seconds = timer.elapsedNanoseconds() / 1000000000.0;
+		result.allocations = s_allocations.load(std::memory_order_relaxed) - allocations;
+		result.seconds = std::min(result.seconds, seconds);
+	}
+
+	return result;
+}
+
+// Convert every leaf into its C++ type
+static size_t getAll(const ruc::Json& json)
+{
+	size_t count = 0;
+	switch (json.type()) {
+	case ruc::Json::Type::Bool:
+		count += json.get<bool>();
+		break;
+	case ruc::Json::Type::Number:
+		count += json.get<double>() > 0;
+		break;
+	case ruc::Json::Type::String:
+		count += json.get<std::string>().size();
+		break;
+	case ruc::Json::Type::Array:
+		// Packed numbers are read without converting the array
+		if (json.asArray().packing() == ruc::json::Array::Packing::Integer) {
+			for (int64_t number : json.asArray().integers()) {
+				count += number > 0;
+			}
+			break;
+		}
+		if (json.asArray().packing() == ruc::json::Array::Packing::Double) {
+			for (double number : json.asArray().doubles()) {
+				count += number > 0;
+			}
+			break;
+		}
+		for (const auto& element : json.asArray().elements()) {
+			count += getAll(element);
+		}
+		break;
+	case ruc::Json::Type::Object:
+		for (const auto& [name, member] : json.asObject().members()) {
+			count += getAll(member);
+		}
+		break;
+	case ruc::Json::Type::Null:
+	default:
+		break;
+	}
+
+	return count;
+}
+
+static ruc::Json toJson(const Measurement& measurement, size_t bytes, size_t documents)
+{
+	ruc::Json json;
+	json["seconds"] = measurement.seconds;
+	json["mbps"] = bytes / (1024.0 * 1024.0) / measurement.seconds;
+	json["allocationsPerDocument"] = static_cast<double>(measurement.allocations) / documents;
+	return json;
+}
+
+static ruc::Json benchmark(const std::string& input, bool ndjson, size_t iterations)
+{
+	// Every line of NDJSON input is a separate document
+	std::vector<std::string_view> documents;
+	if (ndjson) {
+		for (size_t begin = 0, end; begin < input.size(); begin = end + 1) {
+			end = input.find('\n', begin);
+			documents.push_back(std::string_view(input).substr(begin, end - begin));
+		}
+	}
+	else {
+		documents.push_back(input);
+	}
+
+	std::vector<ruc::Json> values(documents.size());
+	auto parse = measure(iterations, [&]() {
+		for (size_t i = 0; i < documents.size(); ++i) {
+			values[i] = ruc::Json::parse(documents[i]);
+		}
+	});
+
+	volatile bool valid = true;
+	auto validate = measure(iterations, [&]() {
+		for (const auto& document : documents) {
+			valid = valid && ruc::json::validate(document);
+		}
+	});
+
+	// Parse again into the same values, recycling their allocations
+	auto into = measure(iterations, [&]() {
+		for (size_t i = 0; i < documents.size(); ++i) {
+			ruc::Json::parseInto(values[i], documents[i]);
+		}
+	});
+
+	std::vector<ruc::json::Tape> tapes(documents.size());
+	auto tape = measure(iterations, [&]() {
+		for (size_t i = 0; i < documents.size(); ++i) {
+			tapes[i] = ruc::json::Tape::parse(documents[i]);
+		}
+	});
+
+	volatile size_t sink = 0;
+
+	// Minify straight from text, without building values
+	ruc::json::Transcoder transcoder;
+	auto minify = measure(iterations, [&]() {
+		for (const auto& document : documents) {
+			transcoder.transcode(document, [&](std::string_view chunk) { sink = sink + chunk.size(); });
+		}
+	});
+
+	size_t dumpBytes = 0;
+	auto dump = measure(iterations, [&]() {
+		dumpBytes = 0;
+		for (const auto& value : values) {
+			dumpBytes += value.dump().size();
+		}
+	});
+
+	auto get = measure(iterations, [&]() {
+		for (const auto& value : values) {
+			sink = sink + getAll(value);
+		}
+	});
+
+	auto copy = measure(iterations, [&]() {
+		for (const auto& value : values) {
+			ruc::Json copy = value;
+			sink = sink + copy.size();
+		}
+	});
+
+	ruc::Json result;
+	result["bytes"] = input.size();
+	result["documents"] = documents.size();
+	result["parse"] = toJson(parse, input.size(), documents.size());
+	result["validate"] = toJson(validate, input.size(), documents.size());
+	result["into"] = toJson(into, input.size(), documents.size());
+	result["tape"] = toJson(tape, input.size(), documents.size());
+	result["minify"] = toJson(minify, input.size(), documents.size());
+	result["dump"] = toJson(dump, dumpBytes, documents.size());
+	result["get"] = toJson(get, input.size(), documents.size());
+	result["copy"] = toJson(copy, input.size(), documents.size());
+	return result;
+}
+
+// -----------------------------------------
+
+int main(int argc, const char* argv[])
+{
+	double megabytes = 4;
+	unsigned int iterations = 3;
+	std::string output;
+	std::string baseline;
+
+	ruc::ArgParser argParser;
+	argParser.addOption(megabytes, 's', "size", "Size of each corpus in megabytes", nullptr, "MB", ruc::ArgParser::Required::Yes);
+	argParser.addOption(iterations, 'i', "iterations", "Run every test N times, keep the fastest", nullptr, "N", ruc::ArgParser::Required::Yes);
+	argParser.addOption(output, 'o', "output", "Write the results as JSON to FILE", nullptr, "FILE", ruc::ArgParser::Required::Yes);
+	argParser.addOption(baseline, 'b', "baseline", "Compare against the results in FILE", nullptr, "FILE", ruc::ArgParser::Required::Yes);
+	if (!argParser.parse(argc, argv)) {
+		return 1;
+	}
+
+	ruc::Json previous;
+	if (!baseline.empty()) {
+		previous = ruc::Json::parse(ruc::File(baseline).data());
+	}
+
+	struct Corpus {
+		const char* name;
+		std::string (*generate)(size_t, Random&);
+		bool ndjson;
+	};
+	const Corpus corpora[] = {
+		{ "numbers", generateNumbers, false },
+		{ "strings", generateStrings, false },
+		{ "nested", generateNested, false },
+		{ "wide", generateWide, false },
+		{ "ndjson", generateNdjson, true },
+	};
+
+	ruc::Json results;
+#ifdef NDEBUG
+	results["build"] = "release";
+#else
+	results["build"] = "debug";
+#endif
+
+	size_t bytes = static_cast<size_t>(megabytes * 1024 * 1024);
+	print("{:<8} {:<8} {:>10} {:>14} {:>10}\n", "corpus", "test", "MB/s", "allocs/doc", "baseline");
+	for (const auto& corpus : corpora) {
+		Random random;
+		std::string input = corpus.generate(bytes, random);
+		ruc::Json result = benchmark(input, corpus.ndjson, iterations);
+
+		for (const char* test : { "parse", "into", "tape", "validate", "minify", "dump", "get", "copy" }) {
+			double mbps = result[test]["mbps"].get<double>();
+
+			std::string change = "-";
+			if (previous.type() == ruc::Json::Type::Object && previous.exists("results")
+			    && previous["results"].exists(corpus.name) && previous["results"][corpus.name].exists(test)) {
+				double before = previous["results"][corpus.name][test]["mbps"].get<double>();
+				change = format("{:.1}%", (mbps / before - 1) * 100);
+			}
+
+			print("{:<8} {:<8} {:>10} {:>14} {:>10}\n", corpus.name, test, format("{:.1}", mbps),
+			      format("{:.1}", result[test]["allocationsPerDocument"].get<double>()), change);
+		}
+
+		results["results"][corpus.name] = result;
+	}
+
+	if (!output.empty()) {
+		auto file = ruc::File::create(output);
+		file.clear();
+		file.append(results.dump(4) + "\n");
+		file.flush();
+	}
+
+	return 0;
+}
@@ -6,19 +6,39 @@
 
 #include <cstddef>    // nullptr_t
 #include <cstdint>    // uint32_t
+#include <filesystem> // temp_directory_path
+#include <fstream>    // ifstream, ofstream
 #include <functional> // function
 #include <map>
+#include <stdexcept> // out_of_range
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility> // as_const
 #include <vector>
 
 #include "macro.h"
 #include "ruc/json/array.h"
+#include "ruc/json/columns.h"
+#include "ruc/json/formatter.h"
+#include "ruc/json/index.h"
 #include "ruc/json/job.h"
 #include "ruc/json/json.h"
 #include "ruc/json/lexer.h"
 #include "ruc/json/parser.h"
+#include "ruc/json/projection.h"
+#include "ruc/json/reclaimer.h"
+#include "ruc/json/schema.h"
 #include "ruc/json/serializer.h"
+#include "ruc/json/shape.h"
+#include "ruc/json/snapshot.h"
+#include "ruc/json/stats.h"
+#include "ruc/json/tape.h"
+#include "ruc/json/transcoder.h"
+#include "ruc/json/validate.h"
+#include "ruc/json/writer.h"
 #include "testcase.h"
 #include "testsuite.h"
 
@@ -152,6 +172,20 @@ TEST_CASE(JsonLexer)
 	EXPECT_EQ(tokens.size(), 2);
 	EXPECT_EQ(tokens[0].symbol, "{");
 	EXPECT_EQ(tokens[1].symbol, "}");
+
+	// Element counts
+
+	tokens = lex(R"([1, [], {"a": [2, 3, 4], "b": {}}, "c,d"])");
+	EXPECT_EQ(tokens[0].count, 4);
+	EXPECT_EQ(tokens[3].count, 0);
+	EXPECT_EQ(tokens[6].count, 2);
+	EXPECT_EQ(tokens[9].count, 3);
+	EXPECT_EQ(tokens[19].count, 0);
+
+	// Parsed arrays are allocated with their exact size
+	auto json = parse("[1, 2, 3, [4, 5, 6, 7, 8], 9]");
+	EXPECT_EQ(json.asArray().elements().capacity(), 5);
+	EXPECT_EQ(json[3].asArray().elements().capacity(), 5);
 }
 
 TEST_CASE(JsonParser)
@@ -568,3 +602,1358 @@ TEST_CASE(JsonSerializer)
 })");
 	// clang-format on
 }
+
+TEST_CASE(JsonSerializerParallel)
+{
+	ruc::Json array;
+	for (size_t i = 0; i < 10000; ++i) {
+		array.emplace_back({ "element", static_cast<double>(i), i % 2 == 0, nullptr, { { "nested", i } } });
+	}
+	EXPECT_EQ(array.dump(0, ' ', 4), array.dump());
+	EXPECT_EQ(array.dump(4, ' ', 4), array.dump(4));
+	EXPECT_EQ(array.dump(1, '\t', 0), array.dump(1, '\t'));
+
+	ruc::Json object;
+	for (size_t i = 0; i < 10000; ++i) {
+		object.emplace("name" + std::to_string(i), { i, "value" });
+	}
+	EXPECT_EQ(object.dump(0, ' ', 3), object.dump());
+	EXPECT_EQ(object.dump(4, ' ', 3), object.dump(4));
+
+	// Small containers are never split
+	EXPECT_EQ(serialize(R"([1,2,3])"), R"([1,2,3])");
+}
+
+TEST_CASE(JsonDeepNesting)
+{
+	constexpr size_t depth = 200000;
+
+	// Parse, copy, serialize, compare, hash and destroy without exhausting the
+	// call stack
+	std::string input = std::string(depth, '[') + std::string(depth, ']');
+	ruc::Json array = parse(input);
+	EXPECT_EQ(array.type(), ruc::Json::Type::Array);
+	{
+		ruc::Json copy = array;
+		EXPECT_EQ(copy.dump(), input);
+		EXPECT(copy == array);
+		EXPECT_EQ(ruc::json::hash(copy, true), ruc::json::hash(array));
+		EXPECT(parse("[" + input + "]") != array);
+	}
+	EXPECT_EQ(array.dump().size(), input.size());
+
+	input.clear();
+	for (size_t i = 0; i < depth; ++i) {
+		input += R"({"a":)";
+	}
+	input += "null" + std::string(depth, '}');
+	ruc::Json object = parse(input);
+	EXPECT_EQ(object.type(), ruc::Json::Type::Object);
+	EXPECT_EQ(ruc::Json(object).dump(), input);
+	EXPECT(ruc::Json(object) == object);
+	EXPECT_NE(ruc::json::hash(object), ruc::json::hash(array));
+
+	// Maximum nesting depth
+	EXEC(
+		ruc::Json tooDeep = ruc::Json::parse("[[[1]]]", 2););
+	EXPECT_EQ(tooDeep.type(), ruc::Json::Type::Null);
+	EXPECT_EQ(ruc::Json::parse("[[[1]]]", 3).dump(), "[[[1]]]");
+	EXPECT_EQ(ruc::Json::parse(R"({"a":{"b":[]}})", 3).dump(), R"({"a":{"b":[]}})");
+
+	EXPECT_EQ(parse("[[1]"), nullptr);
+	EXPECT_EQ(parse(R"({"a":[1,]})"), nullptr);
+	EXPECT_EQ(parse("[1] [2]"), nullptr);
+}
+
+TEST_CASE(JsonParseInto)
+{
+	auto parseInto = [](ruc::Json& target, const std::string& input) -> bool {
+		EXEC(
+			bool result = ruc::Json::parseInto(target, input););
+		return result;
+	};
+
+	std::string first = R"({ "name": "a string that does not fit in a small buffer", "list": [1, 2, 3], "nested": { "flag": true } })";
+	std::string second = R"({ "list": [4, 5], "name": "a shorter string, still on the heap", "nested": { "flag": false, "extra": null } })";
+
+	ruc::Json target;
+	EXPECT(parseInto(target, first));
+	EXPECT_EQ(target, parse(first));
+
+	const void* string = target["name"].asString().data();
+	const ruc::Json* element = &target["list"][0];
+	const ruc::Json* member = &target["nested"];
+
+	// Same shape, the existing allocations are recycled
+	EXPECT(parseInto(target, second));
+	EXPECT_EQ(target, parse(second));
+	EXPECT_EQ(static_cast<const void*>(target["name"].asString().data()), string);
+	EXPECT_EQ(&target["list"][0], element);
+	EXPECT_EQ(&target["nested"], member);
+	EXPECT_EQ(target["list"].size(), 2);
+	EXPECT_EQ(target["nested"].size(), 2);
+
+	// Different shape
+	EXPECT(parseInto(target, R"([{ "name": 1 }, "string", []])"));
+	EXPECT_EQ(target.dump(), R"([{"name":1},"string",[]])");
+	EXPECT(parseInto(target, first));
+	EXPECT_EQ(target, parse(first));
+
+	// Memoized hashes are reset
+	ruc::json::hash(target, true);
+	EXPECT(parseInto(target, second));
+	EXPECT_EQ(ruc::json::hash(target, true), ruc::json::hash(parse(second)));
+
+	// Failure
+	EXPECT(!parseInto(target, R"({ "name": 1, "name": 2 })"));
+	EXPECT_EQ(target, nullptr);
+	EXPECT(parseInto(target, R"({ "name": { "a": 1 } })"));
+	EXPECT_EQ(target.dump(), R"({"name":{"a":1}})");
+	EXPECT(!parseInto(target, R"({ "name": { "a": 1, } })"));
+	EXPECT(parseInto(target, R"({ "other": { "b": 2 } })"));
+	EXPECT_EQ(target.dump(), R"({"other":{"b":2}})");
+
+	// Members recycled under another name start out empty, and more spare
+	// members than are kept are freed
+	std::string wide = "{";
+	for (size_t i = 0; i < 2000; ++i) {
+		wide += (i > 0 ? ",\"m" : "\"m") + std::to_string(i) + R"(": { "a": [1, 2] })";
+	}
+	wide += "}";
+	EXPECT(parseInto(target, wide));
+	EXPECT_EQ(target.size(), 2000);
+	EXPECT(parseInto(target, R"({ "x": {}, "y": [] })"));
+	EXPECT_EQ(target.dump(), R"({"x":{},"y":[]})");
+	EXPECT(parseInto(target, wide));
+	EXPECT_EQ(target, parse(wide));
+}
+
+TEST_CASE(JsonEquality)
+{
+	EXPECT_EQ(parse("null"), parse("null"));
+	EXPECT_EQ(parse("3.14"), parse("3.14"));
+	EXPECT_EQ(parse(R"("string")"), parse(R"("string")"));
+	EXPECT_EQ(parse(R"([1, "2", [3]])"), parse(R"([1,"2",[3]])"));
+	EXPECT_EQ(parse(R"({ "a": 1, "b": [true] })"), parse(R"({ "b": [true], "a": 1 })"));
+
+	EXPECT_NE(parse("null"), parse("false"));
+	EXPECT_NE(parse("0"), parse("false"));
+	EXPECT_NE(parse("[1, 2]"), parse("[2, 1]"));
+	EXPECT_NE(parse("[1, 2]"), parse("[1, 2, 3]"));
+	EXPECT_NE(parse(R"({ "a": 1 })"), parse(R"({ "b": 1 })"));
+	EXPECT_NE(parse(R"({ "a": 1 })"), parse(R"({ "a": 2 })"));
+}
+
+TEST_CASE(JsonHash)
+{
+	ruc::Json left;
+	left.emplace("a", 1);
+	left.emplace("b", { 1, 2, 3 });
+	ruc::Json right;
+	right.emplace("b", { 1, 2, 3 });
+	right.emplace("a", 1);
+	EXPECT_EQ(ruc::json::hash(left), ruc::json::hash(right));
+	EXPECT_NE(ruc::json::hash(parse("[1, 2]")), ruc::json::hash(parse("[2, 1]")));
+	EXPECT_NE(ruc::json::hash(parse("null")), ruc::json::hash(parse("false")));
+	EXPECT_EQ(ruc::json::hash(parse("0")), ruc::json::hash(parse("-0")));
+
+	// Memoized hashes are reset on modification
+	size_t hash = ruc::json::hash(left, true);
+	EXPECT_EQ(left.asObject().cachedHash(), hash);
+	left["b"][0] = 5;
+	EXPECT_EQ(left.asObject().cachedHash(), 0);
+	EXPECT_NE(ruc::json::hash(left, true), hash);
+	EXPECT_NE(left, right);
+	left["b"][0] = 1;
+	EXPECT_EQ(ruc::json::hash(left, true), hash);
+	EXPECT_EQ(left, right);
+
+	// Writes through a retained reference leave the memoized hash behind, it
+	// is not used to tell values apart
+	ruc::Json retained = parse(R"({ "b": [1, 2, 3] })");
+	ruc::Json& element = retained["b"][0];
+	ruc::Json expected = parse(R"({ "b": [5, 2, 3] })");
+	ruc::json::hash(retained, true);
+	ruc::json::hash(expected, true);
+	element = 5;
+	EXPECT_EQ(retained, expected);
+	EXPECT(!(retained == parse(R"({ "b": [1, 2, 3] })")));
+
+	// Parsed values that were only read do short-circuit
+	ruc::Json first = parse(R"({ "a": [1, 2] })");
+	ruc::Json second = parse(R"({ "a": [1, 3] })");
+	ruc::json::hash(first, true);
+	ruc::json::hash(second, true);
+	EXPECT_NE(first, second);
+
+	std::unordered_set<ruc::Json> set;
+	set.insert(parse(R"({ "id": 1, "tags": ["x", "y"] })"));
+	set.insert(parse(R"({ "tags": ["x", "y"], "id": 1 })"));
+	set.insert(parse(R"({ "id": 2, "tags": ["x", "y"] })"));
+	EXPECT_EQ(set.size(), 2);
+}
+
+TEST_CASE(JsonSchema)
+{
+	ruc::json::Schema schema(parse(R"({
+		"type": "object",
+		"properties": {
+			"id": { "type": "integer", "minimum": 1 },
+			"name": { "type": "string", "minLength": 1, "maxLength": 8 },
+			"tags": { "type": "array", "items": { "type": "string" }, "uniqueItems": true },
+			"kind": { "enum": [ "a", "b" ] }
+		},
+		"required": [ "id", "name" ],
+		"additionalProperties": false
+	})"));
+
+	// Validate both the parsed Value and the token stream
+	auto validate = [](const ruc::json::Schema& schema, const std::string& input) -> bool {
+		ruc::Json value;
+		bool valueResult = false;
+		EXEC(valueResult = ruc::Json::parseInto(value, input););
+		valueResult = valueResult && schema.validate(value);
+		bool streamResult = false;
+		EXEC(streamResult = schema.validate(std::string_view(input)););
+		EXPECT_EQ(valueResult, streamResult);
+		return valueResult && streamResult;
+	};
+
+	EXPECT(validate(schema, R"({ "id": 1, "name": "foo", "tags": [ "x", "y" ], "kind": "a" })"));
+	EXPECT(validate(schema, R"({ "name": "foo", "id": 2 })"));
+	EXPECT(!validate(schema, R"({ "id": 1 })"));
+	EXPECT(!validate(schema, R"({ "id": 1.5, "name": "foo" })"));
+	EXPECT(!validate(schema, R"({ "id": 0, "name": "foo" })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "" })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "too long name" })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "foo", "tags": [ "x", "x" ] })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "foo", "tags": [ 1 ] })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "foo", "kind": "c" })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "foo", "other": null })"));
+	EXPECT(!validate(schema, R"([ 1, "foo" ])"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "foo", })"));
+	EXPECT(!validate(schema, R"({ "id": 1, "name": "foo" } 5)"));
+
+	std::string error;
+	EXPECT(!schema.validate(parse(R"({ "id": 1 })"), &error));
+	EXPECT_EQ(error, "missing required member 'name'");
+	EXPECT(!schema.validate(std::string_view(R"({ "id": 1, "name": "foo", "tags": [ "x", 2 ] })"), &error));
+	EXPECT_EQ(error, "/tags/1: unexpected type 'number'");
+
+	ruc::json::Schema composition(parse(R"({
+		"anyOf": [ { "type": "string" }, { "type": "number", "minimum": 0 } ],
+		"not": { "const": "forbidden" }
+	})"));
+	EXPECT(validate(composition, R"("string")"));
+	EXPECT(validate(composition, "5"));
+	EXPECT(!validate(composition, "-1"));
+	EXPECT(!validate(composition, "true"));
+	EXPECT(!validate(composition, R"("forbidden")"));
+
+	ruc::json::Schema tuple(parse(R"({
+		"prefixItems": [ { "type": "number" }, { "type": "string" } ],
+		"items": false
+	})"));
+	EXPECT(validate(tuple, R"([ 1, "a" ])"));
+	EXPECT(!validate(tuple, R"([ "a", 1 ])"));
+	EXPECT(!validate(tuple, R"([ 1, "a", 2 ])"));
+
+	EXPECT(validate(ruc::json::Schema(true), R"({ "anything": [ 1, 2, 3 ] })"));
+	EXPECT(!validate(ruc::json::Schema(false), "null"));
+
+	// Duplicate names are rejected by both, also outside of the properties
+	ruc::json::Schema open(parse(R"({ "properties": { "id": { "type": "number" } } })"));
+	EXPECT(validate(open, R"({ "id": 1, "other": { "a": [ {}, [ 1 ] ], "b": { "a": 2 } } })"));
+	EXPECT(!validate(open, R"({ "id": 1, "other": 1, "other": 2 })"));
+	EXPECT(!validate(open, R"({ "id": 1, "other": [ { "a": 1, "a": 2 } ] })"));
+	EXPECT(!validate(open, R"({ "id": 1, "other": [ 1, ] })"));
+
+	// Subtrees without a schema are walked without recursion, up to the
+	// maximum depth
+	constexpr size_t depth = 200000;
+	std::string deep = R"({ "other": )" + std::string(depth, '[') + std::string(depth, ']') + "}";
+	EXPECT(open.validate(std::string_view(deep)));
+	bool result = true;
+	EXEC(result = open.validate(std::string_view(deep), &error, 64););
+	EXPECT(!result);
+	EXPECT_EQ(error, "/other: exceeded maximum nesting depth");
+	EXPECT(open.validate(std::string_view(R"({ "id": 1, "other": [[]] })"), nullptr, 3));
+	EXEC(result = open.validate(std::string_view(R"({ "id": 1, "other": [[]] })"), nullptr, 2););
+	EXPECT(!result);
+	EXEC(result = schema.validate(std::string_view(R"({ "id": 1, "name": "foo", "tags": [] })"), nullptr, 1););
+	EXPECT(!result);
+
+	// Names that are only required are not exempt from additionalProperties
+	ruc::json::Schema closed(parse(R"({ "required": [ "a" ], "additionalProperties": false })"));
+	EXPECT(!validate(closed, R"({ "a": 1 })"));
+	EXPECT(!validate(closed, "{}"));
+	ruc::json::Schema requiredOnly(parse(R"({ "required": [ "b", "a" ], "properties": { "a": {} } })"));
+	EXPECT(validate(requiredOnly, R"({ "a": 1, "b": 2, "c": 3 })"));
+	EXPECT(!validate(requiredOnly, R"({ "a": 1, "c": 3 })"));
+
+	// Both enum and const have to match
+	ruc::json::Schema both(parse(R"({ "enum": [ 1, 2 ], "const": 2 })"));
+	EXPECT(validate(both, "2"));
+	EXPECT(!validate(both, "1"));
+	EXPECT(!validate(both, "3"));
+
+	// Unsupported or malformed schemas are invalid instead of aborting
+	ruc::json::Schema reference(parse(R"({ "properties": { "a": { "$ref": "#" } } })"));
+	EXPECT(!reference.valid());
+	EXPECT_EQ(reference.error(), "invalid schema: '$ref' is not supported");
+	EXPECT(!reference.validate(parse("{}"), &error));
+	EXPECT_EQ(error, "invalid schema: '$ref' is not supported");
+	EXPECT(!reference.validate(std::string_view("{}")));
+	EXPECT_EQ(ruc::json::Schema(parse(R"({ "minimum": "1" })")).error(), "invalid schema: 'minimum' should be a number");
+	EXPECT(!ruc::json::Schema(parse(R"({ "type": "unknown" })")).valid());
+	EXPECT(!ruc::json::Schema(parse(R"({ "required": "a" })")).valid());
+	EXPECT(!ruc::json::Schema(parse(R"({ "anyOf": [] })")).valid());
+	EXPECT(!ruc::json::Schema(parse("1")).valid());
+	EXPECT(schema.valid());
+
+	// Path segments are escaped like JSON Pointer
+	ruc::json::Schema escaped(parse(R"({ "additionalProperties": { "type": "number" } })"));
+	EXPECT(!escaped.validate(parse(R"({ "a/b~c": "x" })"), &error));
+	EXPECT_EQ(error, "/a~1b~0c: unexpected type 'string'");
+	EXPECT(!escaped.validate(std::string_view(R"({ "a/b~c": "x" })"), &error));
+	EXPECT_EQ(error, "/a~1b~0c: unexpected type 'string'");
+}
+
+TEST_CASE(JsonTape)
+{
+	auto tape = [](const std::string& input) -> ruc::json::Tape {
+		EXEC(
+			ruc::json::Tape result = ruc::json::Tape::parse(input););
+		return result;
+	};
+
+	std::string input = R"({
+		"name": "tape",
+		"escaped": "quote \" tab \t",
+		"version": 3.14,
+		"flags": [ true, false, null ],
+		"nested": { "empty": [], "object": {}, "deep": [[[ -1e3 ]]] },
+		"last": "member"
+	})";
+
+	ruc::json::Tape document = tape(input);
+	EXPECT_EQ(document.root().toValue(), parse(input));
+
+	auto root = document.root();
+	EXPECT_EQ(root.type(), ruc::Json::Type::Object);
+	EXPECT_EQ(root.size(), 6);
+	EXPECT_EQ(root["name"].asString(), "tape");
+	EXPECT_EQ(std::string(root["escaped"].asString()), parse(input)["escaped"].asString());
+	EXPECT_EQ(root["version"].asDouble(), 3.14);
+	EXPECT_EQ(root["flags"].size(), 3);
+	EXPECT_EQ(root["flags"][0].asBool(), true);
+	EXPECT_EQ(root["flags"][1].asBool(), false);
+	EXPECT_EQ(root["flags"][2].type(), ruc::Json::Type::Null);
+	EXPECT_EQ(root["nested"]["empty"].size(), 0);
+	EXPECT_EQ(root["nested"]["object"].type(), ruc::Json::Type::Object);
+	EXPECT_EQ(root["nested"]["deep"][0][0][0].asDouble(), -1000);
+	EXPECT_EQ(root["last"].asString(), "member");
+	EXPECT(root.exists("nested"));
+	EXPECT(!root.exists("missing"));
+	EXPECT(root["flags"].exists(2));
+	EXPECT(!root["flags"].exists(3));
+
+	// Members are kept in document order
+	std::string names;
+	for (auto it = root.begin(); it != root.end(); ++it) {
+		names += std::string(it.name()) + ",";
+	}
+	EXPECT_EQ(names, "name,escaped,version,flags,nested,last,");
+
+	// Skipping a subtree is a single jump
+	EXPECT_EQ(root["nested"].next(), root["last"].next() - 2);
+
+	// Whole document lives in two buffers
+	EXPECT(document.words().size() <= 40);
+
+	EXPECT_EQ(tape("[1, 2, 3]").root().toValue().dump(), "[1,2,3]");
+	EXPECT_EQ(tape(R"("string")").root().asString(), "string");
+	EXPECT_EQ(tape("5").root().asDouble(), 5);
+
+	// Invalid input results in a null document
+	EXPECT_EQ(tape("[1, 2,]").root().type(), ruc::Json::Type::Null);
+	EXPECT_EQ(tape(R"({ "a": 1, "a": 2 })").root().type(), ruc::Json::Type::Null);
+	EXPECT_EQ(tape("[1] 2").root().type(), ruc::Json::Type::Null);
+	EXPECT_EQ(tape("").root().type(), ruc::Json::Type::Null);
+	EXPECT_EQ(tape("[[[]]]").root().type(), ruc::Json::Type::Array);
+	EXEC(
+		auto tooDeep = ruc::json::Tape::parse("[[[]]]", 2););
+	EXPECT_EQ(tooDeep.root().type(), ruc::Json::Type::Null);
+}
+
+TEST_CASE(JsonProjection)
+{
+	std::string input = R"({
+		"user": { "id": 7, "name": "skipped", "tags": ["a", "b"] },
+		"items": [
+			{ "price": 1.5, "description": "a \"quoted\" } string", "nested": [[{}]] },
+			{ "price": 2, "description": null },
+			{ "description": "no price" }
+		],
+		"payload": { "large": [1, 2, [3, { "4": 5 }]], "text": "]}" },
+		"version": 3
+	})";
+
+	ruc::json::Projection projection({ "/user/id", "/items/*/price", "/version" });
+	EXPECT_EQ(projection.parse(input).dump(), R"({"items":[{"price":1.5},{"price":2},{}],"user":{"id":7},"version":3})");
+
+	// Selected containers are kept as a whole
+	EXPECT_EQ(ruc::json::Projection({ "/user/tags" }).parse(input).dump(), R"({"user":{"tags":["a","b"]}})");
+	EXPECT_EQ(ruc::json::Projection({ "" }).parse(input), parse(input));
+
+	// Array indices, a wildcard also applies to the indices that are selected explicitly
+	EXPECT_EQ(ruc::json::Projection({ "/items/1/price" }).parse(input).dump(), R"({"items":[null,{"price":2}]})");
+	EXPECT_EQ(ruc::json::Projection({ "/items/*/price", "/items/2/description" }).parse(input).dump(),
+	          R"({"items":[{"price":1.5},{"price":2},{"description":"no price"}]})");
+
+	// Escaped path segments
+	EXPECT_EQ(ruc::json::Projection({ "/a~1b/~0c" }).parse(R"({ "a/b": { "~c": 1, "d": 2 } })").dump(), R"({"a/b":{"~c":1}})");
+
+	// Missing members and mismatching types
+	EXPECT_EQ(ruc::json::Projection({ "/missing/id" }).parse(input).dump(), "{}");
+	EXPECT_EQ(ruc::json::Projection({ "/version/id" }).parse(input).dump(), R"({"version":null})");
+
+	// Invalid input
+	EXPECT_EQ(projection.parse(R"({ "user": { "id": 7 })"), nullptr);
+	EXPECT_EQ(projection.parse(R"({ "payload": [1, "unterminated] })"), nullptr);
+	EXPECT_EQ(projection.parse(R"({ "version": 1, "version": 2 })"), nullptr);
+	EXPECT_EQ(projection.parse(R"({ "version": 1 } 2)"), nullptr);
+	EXEC(
+		ruc::Json invalid = projection.parse(R"({ "version": 01 })"););
+	EXPECT_EQ(invalid, nullptr);
+}
+
+TEST_CASE(JsonColumns)
+{
+	auto records = parse(R"([
+		{ "id": 1, "price": 2.5, "name": "first", "active": true, "extra": [1] },
+		{ "id": 2, "price": 3, "active": false, "extra": "text" },
+		"not an object",
+		{ "id": null, "price": 4.25, "name": "third" }
+	])");
+
+	ruc::json::ColumnSet columns(records);
+	EXPECT_EQ(columns.rows(), 4);
+	EXPECT_EQ(columns.columns().size(), 5);
+	EXPECT(!columns.exists("missing"));
+
+	const auto& id = columns["id"];
+	EXPECT(id.type == ruc::json::Column::Type::Integer);
+	EXPECT_EQ(id.integers.size(), 4);
+	EXPECT_EQ(id.integers[0], 1);
+	EXPECT_EQ(id.integers[1], 2);
+	EXPECT(!id.isNull(1));
+	EXPECT(id.isNull(2));
+	EXPECT(id.isNull(3));
+
+	const auto& price = columns["price"];
+	EXPECT(price.type == ruc::json::Column::Type::Double);
+	double sum = 0;
+	for (size_t row = 0; row < columns.rows(); ++row) {
+		sum += price.doubles[row];
+	}
+	EXPECT_EQ(sum, 9.75);
+
+	const auto& name = columns["name"];
+	EXPECT(name.type == ruc::json::Column::Type::String);
+	EXPECT_EQ(name.string(0), "first");
+	EXPECT_EQ(name.string(1), "");
+	EXPECT(name.isNull(1));
+	EXPECT_EQ(name.string(3), "third");
+	EXPECT_EQ(name.characters, "firstthird");
+
+	EXPECT(columns["active"].type == ruc::json::Column::Type::Bool);
+	EXPECT_EQ(columns["active"].bools[0], 1);
+	EXPECT_EQ(columns["active"].bools[1], 0);
+
+	const auto& extra = columns["extra"];
+	EXPECT(extra.type == ruc::json::Column::Type::Mixed);
+	EXPECT_EQ(extra.values[0].dump(), "[1]");
+	EXPECT_EQ(extra.values[1].dump(), R"("text")");
+
+	ruc::json::ColumnSet ndjson;
+	EXPECT(ruc::json::ColumnSet::parseNdjson(ndjson, "{\"a\": 1, \"b\": null}\n\n{\"a\": 2.5}\n{\"b\": \"x\"}\n"));
+	EXPECT_EQ(ndjson.rows(), 3);
+	EXPECT(ndjson["a"].type == ruc::json::Column::Type::Double);
+	EXPECT_EQ(ndjson["a"].doubles[1], 2.5);
+	EXPECT(ndjson["a"].isNull(2));
+	EXPECT(ndjson["b"].type == ruc::json::Column::Type::String);
+	EXPECT_EQ(ndjson["b"].string(2), "x");
+
+	// A malformed line fails instead of becoming a row of nulls
+	bool result;
+	size_t line = 0;
+	EXEC(result = ruc::json::ColumnSet::parseNdjson(ndjson, "{\"a\": 1}\n\n{\"a\": }\n{\"a\": 2}\n", &line););
+	EXPECT(!result);
+	EXPECT_EQ(line, 3);
+	EXPECT_EQ(ndjson.rows(), 0);
+	EXPECT(ndjson.columns().empty());
+}
+
+TEST_CASE(JsonKeyLookup)
+{
+	ruc::Json json = parse(R"({ "id": 1, "name": "value", "nested": { "id": 2 } })");
+
+	// Transparent lookup
+	std::string_view name = "name";
+	EXPECT_EQ(json[name].asString(), "value");
+	EXPECT_EQ(json.at(name).asString(), "value");
+	EXPECT(json.exists(name));
+	EXPECT(!json.exists(std::string_view("missing")));
+	EXPECT_EQ(std::as_const(json).at("id").asDouble(), 1);
+
+	// Precomputed keys remember their position per object, for every thread
+	ruc::json::Key id("id");
+	EXPECT_EQ(id.hash(), ruc::json::Key("id").hash());
+	EXPECT(id == ruc::json::Key("id"));
+	EXPECT(!(id == ruc::json::Key("name")));
+	EXPECT_EQ(json[id].asDouble(), 1);
+	EXPECT_EQ(json[id].asDouble(), 1);
+	EXPECT_EQ(json["nested"][id].asDouble(), 2);
+	EXPECT_EQ(json.at(id).asDouble(), 1);
+	EXPECT(json.exists(id));
+
+	json[id] = 3;
+	EXPECT_EQ(json["id"].asDouble(), 3);
+
+	// Removing members drops the remembered position
+	ruc::Json copy = json;
+	EXPECT_EQ(copy[id].asDouble(), 3);
+	copy.clear();
+	EXPECT(!copy.exists(id));
+	copy[id] = 4;
+	EXPECT_EQ(copy["id"].asDouble(), 4);
+	EXPECT_EQ(copy[id].asDouble(), 4);
+
+	EXPECT(ruc::Json::parseInto(json, R"({ "name": "other", "id": 5 })"));
+	EXPECT_EQ(json[id].asDouble(), 5);
+	EXPECT(ruc::Json::parseInto(json, R"({ "name": "other" })"));
+	EXPECT(!json.exists(id));
+
+	ruc::json::Key missing("missing");
+	EXPECT(!json.exists(missing));
+	json[missing] = true;
+	EXPECT_EQ(json.at(missing).asBool(), true);
+	EXPECT_EQ(json.dump(), R"({"missing":true,"name":"other"})");
+
+	// A shared key can be used from several threads at once
+	static const ruc::json::Key shared("id");
+	const ruc::Json records = parse(R"([{"id":1,"name":"a"},{"id":2,"name":"b"}])");
+	std::vector<double> sums(4, 0);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < sums.size(); ++i) {
+		threads.emplace_back([&records, &sums, i]() {
+			ruc::Json object = parse(R"({ "id": 3, "other": 0 })");
+			for (size_t j = 0; j < 1000; ++j) {
+				sums[i] += records.at(j % 2).at(shared).asDouble() + std::as_const(object).at(shared).asDouble();
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (double sum : sums) {
+		EXPECT_EQ(sum, 4500);
+	}
+}
+
+TEST_CASE(JsonValidate)
+{
+	auto errorOffset = [](std::string_view input) -> size_t {
+		ruc::json::SyntaxError error;
+		return ruc::json::validate(input, &error) ? std::string_view::npos : error.offset;
+	};
+
+	EXPECT(ruc::json::validate("null"));
+	EXPECT(ruc::json::validate(" [ true, false, null, -0, 0.5, 1e10, -1.25E-3, \"\" ] "));
+	EXPECT(ruc::json::validate(R"({ "a": { "b": [ {}, [], "long string with \"escapes\" \\ \/ \b \f \n \r \t \u00e9" ] } })"));
+	EXPECT(ruc::json::validate("\"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\""));
+	EXPECT(ruc::json::validate(std::string(10000, '[') + std::string(10000, ']')));
+
+	EXPECT_EQ(errorOffset(""), 0);
+	EXPECT_EQ(errorOffset("[1, 2,]"), 6);
+	EXPECT_EQ(errorOffset(R"({ "a": 1, })"), 10);
+	EXPECT_EQ(errorOffset(R"({ "a" 1 })"), 6);
+	EXPECT_EQ(errorOffset("[1 2]"), 3);
+	EXPECT_EQ(errorOffset("[1] 2"), 4);
+	EXPECT_EQ(errorOffset("[1}"), 2);
+	EXPECT_EQ(errorOffset("[[1]"), 4);
+	EXPECT_EQ(errorOffset("truex"), 4);
+	EXPECT_EQ(errorOffset("truth"), 0);
+	EXPECT_EQ(errorOffset("nul"), 0);
+
+	// Numbers
+	EXPECT_EQ(errorOffset("01"), 1);
+	EXPECT_EQ(errorOffset("-"), 1);
+	EXPECT_EQ(errorOffset("1."), 2);
+	EXPECT_EQ(errorOffset("1e"), 2);
+	EXPECT_EQ(errorOffset("1e+"), 3);
+	EXPECT_EQ(errorOffset("+1"), 0);
+	EXPECT_EQ(errorOffset(".5"), 0);
+
+	// Strings
+	EXPECT_EQ(errorOffset(R"("unterminated)"), 13);
+	EXPECT_EQ(errorOffset("\"tab\tcharacter\""), 4);
+	EXPECT_EQ(errorOffset(R"("\x")"), 2);
+	EXPECT_EQ(errorOffset(R"("\u12G4")"), 5);
+	EXPECT_EQ(errorOffset("\"\xc3\""), 1);
+	EXPECT_EQ(errorOffset("\"\xc0\xaf\""), 1);
+	EXPECT_EQ(errorOffset("\"\xed\xa0\x80\""), 1);
+	EXPECT_EQ(errorOffset("\"\xf4\x90\x80\x80\""), 1);
+	EXPECT_EQ(errorOffset("\"plain ascii text then \xff\""), 23);
+
+	ruc::json::SyntaxError error;
+	EXPECT(!ruc::json::validate("[1, 2,]", &error));
+	EXPECT_EQ(std::string(error.message), "expecting value");
+}
+
+// -----------------------------------------
+
+TEST_CASE(JsonTranscode)
+{
+	// Member order and number text are kept
+	ruc::json::Transcoder minify;
+	EXPECT_EQ(minify.transcode(R"( { "b" : 1.50 , "a" : [ 1e3 , "x\"y" , true , null ] , "c" : { } } )"),
+	          R"({"b":1.50,"a":[1e3,"x\"y",true,null],"c":{}})");
+	EXPECT_EQ(minify.transcode(" \"root\" "), R"("root")");
+	EXPECT_EQ(minify.transcode("-0.0"), "-0.0");
+
+	// Same layout as the serializer
+	auto sameAsDump = [](std::string_view input, uint32_t indent, char indentCharacter) {
+		ruc::json::Transcoder transcoder(indent, indentCharacter);
+		ruc::json::Serializer serializer(indent, indentCharacter);
+		return transcoder.transcode(input) == serializer.dump(ruc::Json::parse(input));
+	};
+	std::string sorted = R"({"a":[1,2,{"b":[],"c":{}}],"d":{"e":null,"f":"g"},"h":[[[]]]})";
+	EXPECT(sameAsDump(sorted, 0, ' '));
+	EXPECT(sameAsDump(sorted, 4, ' '));
+	EXPECT(sameAsDump(sorted, 1, '\t'));
+	EXPECT(sameAsDump("[]", 4, ' '));
+	EXPECT(sameAsDump("{}", 4, ' '));
+
+	// Output arrives in chunks, invalid input writes nothing
+	std::string large = "[";
+	for (size_t i = 0; i < 50000; ++i) {
+		large += i > 0 ? ", \"element\"" : "\"element\"";
+	}
+	large += "]";
+	size_t chunks = 0;
+	std::string output;
+	EXPECT(minify.transcode(large, [&](std::string_view chunk) {
+		chunks++;
+		output += chunk;
+	}));
+	EXPECT(chunks > 1);
+	EXPECT_EQ(output.size(), large.size() - 49999);
+
+	chunks = 0;
+	EXEC(EXPECT(!minify.transcode("[1, 2,]", [&](std::string_view) { chunks++; })));
+	EXPECT_EQ(chunks, 0);
+	EXEC(EXPECT_EQ(minify.transcode(R"({"a":1 "b":2})"), ""));
+
+	// Deep nesting
+	std::string deep = std::string(100000, '[') + std::string(100000, ']');
+	EXPECT_EQ(minify.transcode(deep), deep);
+}
+
+// -----------------------------------------
+
+TEST_CASE(JsonStats)
+{
+	EXPECT_EQ(ruc::Json().memoryUsage(), 0);
+	EXPECT_EQ(ruc::Json(true).memoryUsage(), 0);
+	EXPECT_EQ(ruc::Json(3).memoryUsage(), 0);
+
+	// Short strings live in the small string buffer
+	size_t shortString = ruc::Json("abc").memoryUsage();
+	size_t longString = ruc::Json(std::string(100, 'x')).memoryUsage();
+	EXPECT_EQ(shortString, sizeof(std::string));
+	EXPECT(longString >= shortString + 101);
+
+	// Usage grows with the contents
+	ruc::Json array = ruc::Json::parse("[1, 2, 3]");
+	ruc::Json nested = ruc::Json::parse("[1, 2, 3, [4, 5]]");
+	EXPECT(array.memoryUsage() >= 3 * sizeof(ruc::Json));
+	EXPECT(nested.memoryUsage() > array.memoryUsage());
+
+	ruc::json::ParseStats stats;
+	ruc::Json value = ruc::Json::parse(R"({"a": [1, 2.5, "x", null, true], "b": {"c": [[]]}})", stats);
+	EXPECT_EQ(value["a"][1].asDouble(), 2.5);
+	EXPECT_EQ(stats.bytes, 50);
+	EXPECT_EQ(stats.tokens, 26);
+	EXPECT_EQ(stats.nulls, 1);
+	EXPECT_EQ(stats.bools, 1);
+	EXPECT_EQ(stats.numbers, 2);
+	EXPECT_EQ(stats.strings, 1);
+	EXPECT_EQ(stats.arrays, 3);
+	EXPECT_EQ(stats.objects, 2);
+	EXPECT_EQ(stats.maxDepth, 4);
+	EXPECT_EQ(stats.memoryUsage, value.memoryUsage());
+	EXPECT(stats.allocations >= 8);
+
+	ruc::Json json = stats.toValue();
+	EXPECT_EQ(json["nodes"]["array"].asDouble(), 3);
+	EXPECT_EQ(json["maxDepth"].asDouble(), 4);
+	EXPECT_EQ(json["memoryUsage"].asDouble(), stats.memoryUsage);
+
+	// A failed parse is measured as null
+	EXEC(ruc::Json::parse("[1, 2,]", stats));
+	EXPECT_EQ(stats.nulls, 1);
+	EXPECT_EQ(stats.arrays, 0);
+}
+
+// -----------------------------------------
+
+TEST_CASE(JsonSnapshot)
+{
+	std::string path = (std::filesystem::temp_directory_path() / "ruc-json-snapshot-test.bin").string();
+
+	ruc::Json value = ruc::Json::parse(R"({
+		"name": "reference",
+		"numbers": [1, -2.5, 1.5e+100],
+		"flags": { "a": true, "b": false, "c": null },
+		"empty": [[], {}],
+		"long": "a string that does not fit in the small string buffer"
+	})");
+
+	EXPECT(ruc::json::Snapshot::write(value, path));
+	ruc::json::Snapshot snapshot = ruc::json::Snapshot::load(path);
+	EXPECT(snapshot.valid());
+
+	ruc::json::TapeValue root = snapshot.root();
+	EXPECT(root.type() == ruc::Json::Type::Object);
+	EXPECT_EQ(root.size(), 5);
+	EXPECT_EQ(root["name"].asString(), "reference");
+	EXPECT_EQ(root["numbers"][2].asDouble(), 1.5e+100);
+	EXPECT_EQ(root["flags"]["a"].asBool(), true);
+	EXPECT(root["flags"]["c"].type() == ruc::Json::Type::Null);
+	EXPECT_EQ(root["empty"][1].size(), 0);
+	EXPECT_EQ(root.toValue().dump(), value.dump());
+
+	// Moving keeps the mapping alive
+	ruc::json::Snapshot moved = std::move(snapshot);
+	EXPECT(!snapshot.valid());
+	EXPECT_EQ(moved.root()["long"].asString(), value["long"].asString());
+
+	// A tape parsed straight from text can be written without building values
+	EXPECT(ruc::json::Snapshot::write(ruc::json::Tape::parse("[1, 2, 3]"), path));
+	EXPECT_EQ(ruc::json::Snapshot::load(path).root()[2].asDouble(), 3);
+
+	// Truncated and foreign files are rejected
+	std::string image;
+	{
+		std::ifstream file(path, std::ios::binary);
+		image.assign(std::istreambuf_iterator<char>(file), {});
+	}
+	std::ofstream(path, std::ios::binary | std::ios::trunc).write(image.data(), image.size() - 1);
+	EXPECT(!ruc::json::Snapshot::load(path).valid());
+	std::ofstream(path, std::ios::binary | std::ios::trunc) << "[1, 2, 3] is not an image";
+	EXPECT(!ruc::json::Snapshot::load(path).valid());
+	EXPECT(ruc::json::Snapshot::load(path).root().type() == ruc::Json::Type::Null);
+
+	std::filesystem::remove(path);
+	EXPECT(!ruc::json::Snapshot::load(path).valid());
+}
+
+// -----------------------------------------
+
+TEST_CASE(JsonReclaimer)
+{
+	auto makeTree = []() {
+		ruc::Json tree;
+		for (size_t i = 0; i < 1000; ++i) {
+			tree["member" + std::to_string(i)] = { 1, "two", { { "three", 3 } } };
+		}
+		return tree;
+	};
+
+	{
+		ruc::json::Reclaimer reclaimer(0);
+		ruc::Json tree = makeTree();
+		EXPECT(reclaimer.retire(tree));
+		EXPECT(tree.type() == ruc::Json::Type::Null);
+
+		// Retired values can be reused right away
+		tree = makeTree();
+		EXPECT(reclaimer.retire(tree, 1024 * 1024));
+		reclaimer.drain();
+		EXPECT_EQ(reclaimer.pendingBytes(), 0);
+
+		// Scalars are not queued
+		ruc::Json scalar = "short";
+		EXPECT(!reclaimer.retire(scalar));
+		EXPECT(scalar.type() == ruc::Json::Type::Null);
+	}
+
+	// Over budget trees are freed inline, retiring never waits
+	{
+		constexpr size_t budget = 1024;
+		ruc::json::Reclaimer reclaimer(budget);
+		std::vector<ruc::Json> trees(20, makeTree());
+		for (auto& tree : trees) {
+			reclaimer.retire(tree, budget);
+			EXPECT(tree.type() == ruc::Json::Type::Null);
+			EXPECT(reclaimer.pendingBytes() <= budget);
+		}
+		reclaimer.drain();
+		EXPECT_EQ(reclaimer.pendingBytes(), 0);
+
+		// Without an estimate only the top-level container is counted
+		ruc::Json tree = makeTree();
+		EXPECT(reclaimer.retire(tree));
+		reclaimer.drain();
+	}
+
+	// Queued trees are freed when the reclaimer is destroyed
+	{
+		ruc::json::Reclaimer reclaimer;
+		for (size_t i = 0; i < 10; ++i) {
+			ruc::Json tree = makeTree();
+			reclaimer.retire(tree);
+		}
+	}
+}
+
+// -----------------------------------------
+
+TEST_CASE(JsonShapes)
+{
+	std::string input = R"([{"id":1,"name":"a"},{"id":2,"name":"b"},{"id":3,"name":"c"},{"other":true}])";
+	ruc::Json records = ruc::Json::parse(input);
+
+	// Elements with the same names share a shape
+	const ruc::json::Shape* shape = records[0].asObject().shape();
+	EXPECT(shape != nullptr);
+	EXPECT(records[1].asObject().shape() == shape);
+	EXPECT(records[2].asObject().shape() == shape);
+	EXPECT(records[3].asObject().shape() == nullptr);
+	EXPECT_EQ(shape->size(), 2);
+	EXPECT_EQ(shape->find("name"), 1);
+	EXPECT_EQ(shape->find("missing"), ruc::json::Shape::npos);
+
+	EXPECT_EQ(records.dump(), input);
+	EXPECT_EQ(records[1]["name"].asString(), "b");
+	EXPECT(!records[1].exists("missing"));
+
+	// A key resolves its slot once for every object with the shape
+	ruc::json::Key id("id");
+	double sum = 0;
+	for (size_t i = 0; i < 3; ++i) {
+		sum += records.at(i).at(id).asDouble();
+	}
+	EXPECT_EQ(sum, 6);
+
+	// Members can be iterated and compared like any other object
+	std::string names;
+	for (const auto& [name, value] : records[2].asObject().members()) {
+		names += name;
+	}
+	EXPECT_EQ(names, "idname");
+	ruc::Json unshaped;
+	unshaped["name"] = "c";
+	unshaped["id"] = 3;
+	EXPECT(unshaped == records[2]);
+
+	// Names are stored once for all objects with the shape
+	ruc::Json unshapedRecords;
+	for (size_t i = 0; i < 4; ++i) {
+		unshapedRecords[i] = ruc::Json::Type::Object;
+		for (const auto& [name, value] : records[i].asObject().members()) {
+			unshapedRecords[i][name] = value;
+		}
+	}
+	EXPECT(unshapedRecords == records);
+	EXPECT(unshapedRecords[0].asObject().shape() == nullptr);
+	EXPECT(records.memoryUsage() < unshapedRecords.memoryUsage());
+
+	// Copies share the shape
+	ruc::Json copy = records;
+	EXPECT(copy[0].asObject().shape() == shape);
+	EXPECT(copy == records);
+
+	// Changing a value keeps the shape, adding a name only unshapes that object
+	records[0]["name"] = "changed";
+	EXPECT(records[0].asObject().shape() == shape);
+	records[0]["added"] = true;
+	EXPECT(records[0].asObject().shape() == nullptr);
+	EXPECT_EQ(records[0].size(), 3);
+	EXPECT_EQ(records[0]["name"].asString(), "changed");
+	EXPECT(records[1].asObject().shape() == shape);
+	EXPECT_EQ(records.at(0).at(id).asDouble(), 1);
+
+	// Parsing into shaped records keeps their shape
+	ruc::Json target = ruc::Json::parse(input);
+	const ruc::json::Shape* before = target[0].asObject().shape();
+	EXPECT(ruc::Json::parseInto(target, R"([{"id":4,"name":"d"},{"id":5,"name":"e"}])"));
+	EXPECT(target[0].asObject().shape() == before);
+	EXPECT(target[1].asObject().shape() == before);
+	EXPECT_EQ(target.dump(), R"([{"id":4,"name":"d"},{"id":5,"name":"e"}])");
+	EXPECT(ruc::Json::parseInto(target, R"([{"id":6},{"id":7,"name":"f"}])"));
+	EXPECT(target[0].asObject().shape() == nullptr);
+	EXPECT_EQ(target.dump(), R"([{"id":6},{"id":7,"name":"f"}])");
+}
+
+TEST_CASE(JsonIndex)
+{
+	ruc::Json records = ruc::Json::parse(R"([
+		{ "id": 1, "name": "a", "region": { "code": "eu" } },
+		{ "id": 2, "name": "b", "region": { "code": "us" } },
+		{ "id": 3, "name": "a", "region": { "code": "eu" } },
+		{ "name": "no id" },
+		4
+	])");
+
+	ruc::json::Index byId(records, { "/id" });
+	EXPECT_EQ(byId.size(), 3);
+	EXPECT(byId.find(2) == &records.asArray().elements()[1]);
+	EXPECT(byId.find(5) == nullptr);
+	EXPECT(byId.find("2") == nullptr);
+
+	// A unique index keeps the first element, a multiple index all of them
+	ruc::json::Index byName(records, { "/name" });
+	EXPECT_EQ(byName.find("a")->at("id").asDouble(), 1);
+	ruc::json::Index allByName(records, { "/name" }, ruc::json::Index::Type::Multiple);
+	auto named = allByName.findAll("a");
+	EXPECT_EQ(named.size(), 2);
+	EXPECT_EQ(named[0]->at("id").asDouble(), 1);
+	EXPECT_EQ(named[1]->at("id").asDouble(), 3);
+	EXPECT(allByName.findAll("c").empty());
+
+	// Nested paths and keys over multiple paths
+	ruc::json::Index byRegion(records, { "/region/code", "/name" }, ruc::json::Index::Type::Multiple);
+	EXPECT_EQ(byRegion.findAll({ "eu", "a" }).size(), 2);
+	EXPECT_EQ(byRegion.findAll({ "us", "a" }).size(), 0);
+
+	// Any mutable access makes the index stale, until it is rebuilt
+	EXPECT(!byId.stale());
+	records.emplace_back(ruc::Json { { "id", 5 } });
+	EXPECT(byId.stale());
+	EXPECT(allByName.stale());
+	byId.rebuild();
+	EXPECT(!byId.stale());
+	EXPECT_EQ(byId.find(5)->at("id").asDouble(), 5);
+
+	records[0]["id"] = 6;
+	EXPECT(byId.stale());
+	EXPECT(byId.find(5) == nullptr);
+	EXPECT(allByName.findAll("a").empty());
+	byId.rebuild();
+	EXPECT(byId.find(1) == nullptr);
+	EXPECT(byId.find(6) == &records.asArray().elements()[0]);
+
+	// Const access does not
+	const ruc::Json& constRecords = records;
+	EXPECT_EQ(constRecords[1]["id"].asDouble(), 2);
+	EXPECT_EQ(constRecords.at(2).at("name").asString(), "a");
+	EXPECT(!byId.stale());
+	EXPECT(byId.find(2) == &constRecords[1]);
+
+	// Missing elements and members throw on const access, instead of being
+	// added like on mutable access
+	auto throws = [](auto function) -> bool {
+		try {
+			function();
+		}
+		catch (const std::out_of_range&) {
+			return true;
+		}
+		return false;
+	};
+	size_t size = constRecords.size();
+	EXPECT(throws([&constRecords]() { return constRecords[100]; }));
+	EXPECT(throws([&constRecords]() { return constRecords[0]["missing"]; }));
+	EXPECT(throws([&constRecords]() { return constRecords[0][ruc::json::Key("missing")]; }));
+	EXPECT(!throws([&constRecords]() { return constRecords[0]["id"]; }));
+	EXPECT_EQ(constRecords.size(), size);
+	EXPECT(!constRecords[0].exists("missing"));
+	EXPECT(!byId.stale());
+	records[0]["missing"];
+	EXPECT(records[0].exists("missing"));
+
+	// Replacing the array is seen as well
+	records = ruc::Json::parse(R"([{ "id": 6 }])");
+	EXPECT(byId.stale());
+	byId.rebuild();
+	EXPECT_EQ(byId.size(), 1);
+
+	// Indexes over shaped records
+	ruc::Json large;
+	for (size_t i = 0; i < 1000; ++i) {
+		large.emplace_back(ruc::Json { { "id", i }, { "value", i * 2 } });
+	}
+	ruc::json::Index byLargeId(large, { "/id" });
+	EXPECT_EQ(byLargeId.size(), 1000);
+	EXPECT_EQ(byLargeId.find(777)->at("value").asDouble(), 1554);
+	ruc::Json parsed = ruc::Json::parse(large.dump());
+	EXPECT(parsed[0].asObject().shape() != nullptr);
+	ruc::json::Index byParsedId(parsed, { "/id" });
+	EXPECT_EQ(byParsedId.find(999)->at("value").asDouble(), 1998);
+
+	// Indexes and memoized hashes can be built by several readers at once
+	std::vector<size_t> found(4, 0);
+	std::vector<size_t> hashes(4, 0);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < found.size(); ++i) {
+		threads.emplace_back([&parsed, &found, &hashes, i]() {
+			ruc::json::Index index(parsed, { "/id" });
+			found[i] = index.find(500) != nullptr;
+			hashes[i] = ruc::json::hash(parsed, true);
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (size_t i = 0; i < found.size(); ++i) {
+		EXPECT_EQ(found[i], 1);
+		EXPECT_EQ(hashes[i], ruc::json::hash(parsed));
+	}
+	EXPECT(!byParsedId.stale());
+}
+
+TEST_CASE(JsonPackedArrays)
+{
+	using Packing = ruc::json::Array::Packing;
+
+	std::string integers = "[0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,-16,17,18,19]";
+	ruc::Json json = ruc::Json::parse(integers);
+	EXPECT(json.asArray().packing() == Packing::Integer);
+	EXPECT_EQ(json.size(), 20);
+	EXPECT_EQ(json.asArray().integers()[16], -16);
+	EXPECT_EQ(json.dump(), integers);
+	EXPECT_EQ(json.get<std::vector<int64_t>>()[19], 19);
+	EXPECT_EQ(json.get<std::vector<double>>()[16], -16);
+
+	// Small arrays and arrays with other values are not packed
+	EXPECT(ruc::Json::parse("[1, 2, 3]").asArray().packing() == Packing::None);
+	EXPECT(ruc::Json::parse("[0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,null]").asArray().packing() == Packing::None);
+
+	std::string doubles = "[0.5,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]";
+	ruc::Json packed = ruc::Json::parse(doubles);
+	EXPECT(packed.asArray().packing() == Packing::Double);
+	EXPECT_EQ(packed.asArray().doubles()[0], 0.5);
+	EXPECT_EQ(packed.dump(), doubles);
+
+	// Packed and unpacked arrays are equal and hash the same
+	ruc::Json copy = packed;
+	EXPECT(copy.asArray().packing() == Packing::Double);
+	ruc::Json values = ruc::Json::parse(doubles);
+	values.at(0); // Mutable access converts
+	EXPECT(values.asArray().packing() == Packing::None);
+	EXPECT(packed == values);
+	EXPECT(values == copy);
+	EXPECT_EQ(ruc::json::hash(packed), ruc::json::hash(values));
+	EXPECT(packed.memoryUsage() < values.memoryUsage());
+	EXPECT_EQ(ruc::json::Tape::fromValue(packed).root().toValue(), values);
+
+	// Numbers keep the array packed, integers become doubles when needed
+	json.emplace_back(20);
+	EXPECT(json.asArray().packing() == Packing::Integer);
+	json.emplace_back(20.5);
+	EXPECT(json.asArray().packing() == Packing::Double);
+	EXPECT_EQ(json.asArray().doubles()[21], 20.5);
+	json.emplace_back("text");
+	EXPECT(json.asArray().packing() == Packing::None);
+	EXPECT_EQ(json.size(), 23);
+	EXPECT_EQ(json[22].asString(), "text");
+	EXPECT_EQ(json[16].asDouble(), -16);
+
+	// Const element access keeps the array packed, mutable access converts it
+	auto span = std::as_const(copy).asArray().doubles();
+	EXPECT_EQ(std::as_const(copy).at(0).asDouble(), 0.5);
+	EXPECT_EQ(std::as_const(copy)[16].asDouble(), 16);
+	EXPECT(copy.asArray().packing() == Packing::Double);
+	EXPECT_EQ(span[16], 16);
+	EXPECT_EQ(copy.at(0).asDouble(), 0.5);
+	EXPECT(copy.asArray().packing() == Packing::None);
+
+	// Negative zero is not packed as an integer
+	std::string zeros = "[-0,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15]";
+	EXPECT(ruc::Json::parse(zeros).asArray().packing() == Packing::Double);
+	EXPECT_EQ(ruc::Json::parse(zeros).dump(), zeros);
+	EXPECT_EQ(ruc::Json(std::vector<double> { -0.0, 1 }).dump(), "[-0,1]");
+
+	// Vectors of numbers are stored packed
+	ruc::Json vector = std::vector<int> { 1, 2, 3 };
+	EXPECT(vector.asArray().packing() == Packing::Integer);
+	EXPECT_EQ(vector.dump(), "[1,2,3]");
+	EXPECT(ruc::Json(std::vector<bool> { true }).asArray().packing() == Packing::None);
+
+	// Parsing into a packed array packs it again
+	ruc::Json target = ruc::Json::parse(doubles);
+	EXPECT(ruc::Json::parseInto(target, integers));
+	EXPECT(target.asArray().packing() == Packing::Integer);
+	EXPECT_EQ(target.dump(), integers);
+	EXPECT(ruc::Json::parseInto(target, R"(["a", 1])"));
+	EXPECT(target.asArray().packing() == Packing::None);
+	EXPECT_EQ(target.dump(), R"(["a",1])");
+}
+
+TEST_CASE(JsonTapeDedupe)
+{
+	std::string input = R"({
+		"records": [
+			{ "status": "active", "tags": ["a", "b"], "owner": { "name": "x", "level": 1 } },
+			{ "status": "active", "tags": ["a", "b"], "owner": { "name": "x", "level": 1 } },
+			{ "status": "inactive", "tags": ["a", "b"], "owner": { "name": "x", "level": 2 } },
+			{ "status": "active", "tags": ["a", "b"], "owner": { "name": "x", "level": 1 } }
+		],
+		"status": "active",
+		"empty": [[], [], {}]
+	})";
+
+	ruc::json::DedupeStats stats;
+	ruc::json::Tape shared = ruc::json::Tape::parse(input, stats);
+	ruc::json::Tape plain = ruc::json::Tape::parse(input);
+
+	// Reads the same as a tape without sharing
+	EXPECT_EQ(shared.root().toValue(), parse(input));
+	EXPECT_EQ(shared.root().toValue(), plain.root().toValue());
+
+	auto records = shared.root()["records"];
+	EXPECT_EQ(records.size(), 4);
+	EXPECT_EQ(records[3]["owner"]["level"].asDouble(), 1);
+	EXPECT_EQ(records[2]["status"].asString(), "inactive");
+	EXPECT_EQ(records[3]["tags"][1].asString(), "b");
+	EXPECT(records[3].exists("owner"));
+
+	std::string names;
+	for (auto it = records[1].begin(); it != records[1].end(); ++it) {
+		names += std::string(it.name()) + ",";
+	}
+	EXPECT_EQ(names, "status,tags,owner,");
+
+	// Repeated records and their children are stored once
+	EXPECT_EQ(stats.sharedSubtrees, 7);
+	EXPECT(stats.sharedStrings > stats.strings / 2);
+	EXPECT(shared.words().size() < plain.words().size());
+	EXPECT(shared.strings().size() < plain.strings().size());
+	EXPECT_EQ(stats.bytes, shared.words().size() * sizeof(uint64_t) + shared.strings().size());
+	EXPECT_EQ(stats.bytes + stats.savedBytes, plain.words().size() * sizeof(uint64_t) + plain.strings().size());
+	EXPECT(stats.ratio() > 1.5);
+
+	// Shared values survive a snapshot
+	std::string path = (std::filesystem::temp_directory_path() / "ruc-json-dedupe.snapshot").string();
+	EXPECT(ruc::json::Snapshot::write(shared, path));
+	ruc::json::Snapshot snapshot = ruc::json::Snapshot::load(path);
+	EXPECT_EQ(snapshot.root().toValue(), parse(input));
+	std::filesystem::remove(path);
+
+	// Invalid input
+	EXEC(
+		auto invalid = ruc::json::Tape::parse(R"([{ "a": 1 }, { "a": 1, "a": 1 }])", stats););
+	EXPECT_EQ(invalid.root().type(), ruc::Json::Type::Null);
+	EXPECT_EQ(stats.sharedSubtrees, 0);
+	EXPECT_EQ(stats.ratio(), 1);
+}
+
+TEST_CASE(JsonDumpCached)
+{
+	ruc::Json built;
+	for (size_t i = 0; i < 20; ++i) {
+		built["services"]["service" + std::to_string(i)] = { { "enabled", true }, { "port", 8000 + i }, { "hosts", { "a.example", "b.example" } } };
+	}
+	built["version"] = 1;
+	EXPECT_EQ(built.dumpCached(), built.dump());
+	EXPECT(std::as_const(built)["services"].asObject().cachedOutput() == nullptr); // Lent while building
+
+	// Same output as a regular dump, compact and indented
+	ruc::Json json = parse(built.dump());
+	EXPECT_EQ(json.dumpCached(), json.dump());
+	EXPECT_EQ(json.dumpCached(4), json.dump(4));
+	EXPECT_EQ(json.dumpCached(4), json.dump(4));
+	EXPECT_EQ(json.dumpCached(2, '\t'), json.dump(2, '\t'));
+	const auto& services = std::as_const(json)["services"].asObject();
+	EXPECT(services.cachedOutput() != nullptr);
+	EXPECT_EQ(services.cachedOutput()->indent, 2);
+
+	// Modifications drop the output of every container on the way down
+	EXPECT_EQ(json.dumpCached(4), json.dump(4));
+	json["services"]["service3"]["port"] = 9000;
+	EXPECT(services.cachedOutput() == nullptr);
+	EXPECT(std::as_const(json)["services"]["service3"].asObject().cachedOutput() == nullptr);
+	EXPECT(std::as_const(json)["services"]["service4"].asObject().cachedOutput() != nullptr);
+	EXPECT_EQ(json.dumpCached(), json.dump());
+	EXPECT(json.dump().find("\"port\":9000") != std::string::npos);
+
+	json["services"]["service7"]["hosts"].emplace_back("c.example");
+	json["services"].emplace("extra", nullptr);
+	EXPECT_EQ(json.dumpCached(4), json.dump(4));
+
+	// Writes through references that were handed out before a dump are seen
+	ruc::Json& port = json["services"]["service5"]["port"];
+	ruc::Json& hosts = json["services"]["service6"]["hosts"];
+	EXPECT_EQ(json.dumpCached(), json.dump());
+	EXPECT(services.cachedOutput() == nullptr);
+	port = 1234;
+	hosts.emplace_back("d.example");
+	EXPECT_EQ(json.dumpCached(), json.dump());
+	EXPECT(json.dump().find("\"port\":1234") != std::string::npos);
+	EXPECT(json.dump().find("\"d.example\"") != std::string::npos);
+
+	// Kept output is counted as memory of the value
+	ruc::Json copy = json;
+	EXPECT(copy.asObject().cachedOutput() == nullptr);
+	EXPECT(json.memoryUsage() > copy.memoryUsage());
+}
+
+TEST_CASE(JsonRawNumbers)
+{
+	std::string input = R"({"big":12345678901234567890,"exponent":1E+3,"negative":-0,"pi":3.14,"precise":0.10000000000000000555})";
+
+	ruc::Json json = ruc::Json::parseRawNumbers(input);
+	EXPECT_EQ(json.dump(), input);
+	EXPECT_EQ(json["exponent"].rawNumber(), "1E+3");
+	EXPECT_EQ(json["exponent"].asDouble(), 1000);
+	EXPECT_EQ(json["pi"].get<double>(), 3.14);
+	EXPECT_EQ(json["big"].get<uint64_t>(), 12345678901234567890ull);
+	EXPECT_EQ(json["pi"].get<int>(), 3);
+	EXPECT(json == parse(input));
+	EXPECT_EQ(ruc::json::hash(json), ruc::json::hash(parse(input)));
+	EXPECT(parse(input)["pi"].rawNumber().empty());
+
+	// Copies keep the text, assigning a number replaces it
+	ruc::Json copy = json;
+	EXPECT_EQ(copy.dump(), input);
+	copy["pi"] = 3;
+	EXPECT(copy["pi"].rawNumber().empty());
+	EXPECT_EQ(copy["pi"].dump(), "3");
+	copy["big"].clear();
+	EXPECT_EQ(copy["big"].dump(), "0");
+	EXPECT(json.memoryUsage() > parse(input).memoryUsage());
+
+	// Large arrays of raw numbers are not packed
+	std::string numbers = "[1.10,2.20,3.30,4.40,5.50,6.60,7.70,8.80,9.90,10.10,11.10,12.10,13.10,14.10,15.10,16.10,17.10]";
+	ruc::Json array = ruc::Json::parseRawNumbers(numbers);
+	EXPECT(array.asArray().packing() == ruc::json::Array::Packing::None);
+	EXPECT_EQ(array.dump(), numbers);
+
+	// Exponents directly after a single digit are valid numbers
+	EXPECT_EQ(parse("1e3").asDouble(), 1000);
+	EXPECT_EQ(parse("[2E-1]")[0].asDouble(), 0.2);
+	EXEC(
+		ruc::Json invalid = ruc::Json::parseRawNumbers("[1.e5]"););
+	EXPECT_EQ(invalid.type(), ruc::Json::Type::Null);
+}
+
+TEST_CASE(JsonLiteral)
+{
+	constexpr const auto& document = R"({
+		"name": "literal",
+		"escaped": "quote \" slash \/ tab \t",
+		"version": 3.14,
+		"ports": [80, 443, -1.5e-3],
+		"flags": [true, false, null],
+		"nested": { "empty": [], "object": {}, "deep": [[{ "a": 1 }]] }
+	})"_jsondoc;
+
+	// Parsed while building, read in place
+	static_assert(document.words[0] >> 56 == static_cast<uint64_t>(ruc::json::detail::TapeTag::Object));
+	auto root = document.root();
+	EXPECT_EQ(root.size(), 6);
+	EXPECT_EQ(root["name"].asString(), "literal");
+	EXPECT_EQ(root["version"].asDouble(), 3.14);
+	EXPECT_EQ(root["ports"][2].asDouble(), -1.5e-3);
+	EXPECT_EQ(root["nested"]["deep"][0][0]["a"].asDouble(), 1);
+
+	// Converts to the same value as a runtime parse
+	ruc::Json json = document;
+	EXPECT_EQ(json, parse(R"({
+		"name": "literal",
+		"escaped": "quote \" slash \/ tab \t",
+		"version": 3.14,
+		"ports": [80, 443, -1.5e-3],
+		"flags": [true, false, null],
+		"nested": { "empty": [], "object": {}, "deep": [[{ "a": 1 }]] }
+	})"));
+	EXPECT_EQ(json["escaped"].asString(), parse(R"("quote \" slash \/ tab \t")").asString());
+
+	EXPECT_EQ("[0.1, 1e22, 123456789012345678, -0, 2.5E-7]"_jsondoc.toValue(), parse("[0.1, 1e22, 123456789012345678, -0, 2.5E-7]"));
+	EXPECT_EQ(ruc::Json("5"_jsondoc).asDouble(), 5);
+	EXPECT_EQ(std::string("\"text\""_jsondoc.root().asString()), "text");
+
+	// Every document literal is a single constant
+	EXPECT_EQ(&"[1]"_jsondoc, &"[1]"_jsondoc);
+
+	// _json is a Value, which can be modified and dumped like before
+	auto value = R"({ "a": [1, 2] })"_json;
+	value["x"] = 1;
+	EXPECT_EQ(value.dump(), R"({"a":[1,2],"x":1})");
+	EXPECT_EQ("[true, null]"_json.dump(), "[true,null]");
+	EXPECT_EQ("[1]"_json, parse("[1]"));
+}
+
+TEST_CASE(JsonWriter)
+{
+	auto write = [](ruc::json::Writer& writer) {
+		writer.beginObject()
+			.key("array")
+			.beginArray()
+			.value(1)
+			.value(2.5)
+			.value(nullptr)
+			.beginArray()
+			.endArray()
+			.endArray()
+			.key("escaped")
+			.value("quote \" backslash \\")
+			.key("nested")
+			.beginObject()
+			.key("empty")
+			.beginObject()
+			.endObject()
+			.key("value")
+			.value(parse(R"({ "b": [true, false], "a": "text" })"))
+			.endObject()
+			.endObject();
+	};
+
+	// Same layout as a dump of the same value
+	const char* input = R"({
+		"array": [1, 2.5, null, []],
+		"escaped": "quote \" backslash \\",
+		"nested": { "empty": {}, "value": { "a": "text", "b": [true, false] } }
+	})";
+	for (uint32_t indent : { 0, 4 }) {
+		ruc::json::Writer writer(indent);
+		write(writer);
+		EXPECT(writer.complete());
+		EXPECT_EQ(writer.output(), parse(input).dump(indent));
+	}
+
+	// Output is handed to the sink and the buffer is reused
+	std::string result;
+	ruc::json::Writer writer([&result](std::string_view chunk) { result += chunk; }, 2, '\t');
+	write(writer);
+	writer.flush();
+	EXPECT(writer.output().empty());
+	EXPECT_EQ(result, parse(input).dump(2, '\t'));
+
+	writer.clear();
+	writer.value(static_cast<uint64_t>(18446744073709551615u));
+	writer.flush();
+	EXPECT_EQ(result.substr(result.size() - 20), "18446744073709551615");
+	EXPECT_EQ(ruc::json::Writer().value("tab \t control \x01").output(), R"("tab \t control \u0001")");
+}
+
+TEST_CASE(JsonFormatter)
+{
+	auto json = parse(R"({ "name": "format", "list": [1, 2.5, null, {}], "nested": { "flag": true } })");
+
+	EXPECT_EQ(format("{}", json), json.dump(4));
+	EXPECT_EQ(format("{:2}", json), json.dump(2));
+	EXPECT_EQ(format("{:\t<1}", json), json.dump(1, '\t'));
+	EXPECT_EQ(format("{:c}", json), json.dump());
+	EXPECT_EQ(format("value: {:c}.", json), "value: " + json.dump() + ".");
+
+	// Output larger than a chunk is handed over in parts
+	ruc::Json large;
+	for (size_t i = 0; i < 10000; ++i) {
+		large[i] = { { "index", i }, { "text", "chunked output" } };
+	}
+	EXPECT_EQ(format("{:c}", large), large.dump());
+}